@@ -0,0 +1,99 @@
+#ifndef FFT_STOCKHAM_GLSL
+#define FFT_STOCKHAM_GLSL
+
+// Stockham autosort inverse FFT in shared memory: radix-4 stages, plus one radix-2 stage when
+// log2(N) is odd. FFT_COUNT sequences are transformed side by side so they share barriers.
+//
+// The includer defines FFT_COUNT, declares the specialization constants N (id 0), LOGN (id 1) and
+// local_size_x_id = 2 (set to N/4), declares `tw[]` with tw[k] = e^{+2 pi i k / N},
+// and implements fftStore(k, v), which receives output element k of every sequence.
+// Run by N/4 threads; thread j passes its stage-0 inputs x[f][r] = sequence f at index j + r*N/4,
+// so the first stage never touches shared memory and the last one goes straight to fftStore.
+
+#include "complex.glsl"
+
+const uint LOG4N  = LOGN / 2u; // radix-4 stages
+const uint RADIX2 = LOGN & 1u; // trailing radix-2 stage
+
+shared vec2 sFft[FFT_COUNT * 2u * N];
+
+void fftStore(uint k, vec2 v[FFT_COUNT]);
+
+uint fftSlot(uint f, uint buf, uint i){ return (f * 2u + buf) * N + i; }
+
+void fftStockhamInverse(uint j, vec2 x[FFT_COUNT][4]){
+    const uint Q = N / 4u;
+    vec2 v[FFT_COUNT][4] = x;
+    uint src = 0u;
+
+    for (uint s = 0u; s < LOG4N; ++s){
+        uint Ns = 1u << (2u * s);
+
+        if (s > 0u){
+            for (uint f = 0u; f < FFT_COUNT; ++f)
+                for (uint r = 0u; r < 4u; ++r)
+                    v[f][r] = sFft[fftSlot(f, src, j + r * Q)];
+        }
+
+        uint jm = j & (Ns - 1u);
+        uint k  = jm * (N / (Ns * 4u));
+        vec2 w1 = tw[k];
+        vec2 w2 = tw[2u * k];
+        vec2 w3 = tw[3u * k];
+
+        // inverse radix-4 butterfly
+        vec2 X[FFT_COUNT][4];
+        for (uint f = 0u; f < FFT_COUNT; ++f){
+            vec2 a0 = v[f][0];
+            vec2 a1 = cmul(v[f][1], w1);
+            vec2 a2 = cmul(v[f][2], w2);
+            vec2 a3 = cmul(v[f][3], w3);
+            vec2 t0 = a0 + a2;
+            vec2 t1 = a0 - a2;
+            vec2 t2 = a1 + a3;
+            vec2 t3 = mulI(a1 - a3);
+            X[f][0] = t0 + t2;
+            X[f][1] = t1 + t3;
+            X[f][2] = t0 - t2;
+            X[f][3] = t1 - t3;
+        }
+
+        uint d = (j - jm) * 4u + jm;
+
+        if (RADIX2 == 0u && s == LOG4N - 1u){
+            for (uint r = 0u; r < 4u; ++r){
+                vec2 o[FFT_COUNT];
+                for (uint f = 0u; f < FFT_COUNT; ++f) o[f] = X[f][r];
+                fftStore(d + r * Ns, o);
+            }
+        } else {
+            uint dst = 1u - src;
+            for (uint f = 0u; f < FFT_COUNT; ++f)
+                for (uint r = 0u; r < 4u; ++r)
+                    sFft[fftSlot(f, dst, d + r * Ns)] = X[f][r];
+            src = dst;
+            barrier();
+        }
+    }
+
+    if (RADIX2 == 0u)
+        return;
+
+    // Ns = N/2, two butterflies per thread
+    for (uint h = 0u; h < 2u; ++h){
+        uint jj = j + h * Q;
+        vec2 w = tw[jj];
+        vec2 o0[FFT_COUNT];
+        vec2 o1[FFT_COUNT];
+        for (uint f = 0u; f < FFT_COUNT; ++f){
+            vec2 a = sFft[fftSlot(f, src, jj)];
+            vec2 b = cmul(sFft[fftSlot(f, src, jj + N / 2u)], w);
+            o0[f] = a + b;
+            o1[f] = a - b;
+        }
+        fftStore(jj, o0);
+        fftStore(jj + N / 2u, o1);
+    }
+}
+
+#endif
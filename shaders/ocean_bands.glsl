@@ -0,0 +1,79 @@
+#ifndef OCEAN_BANDS_GLSL
+#define OCEAN_BANDS_GLSL
+
+// Sampling side of the spectral bands. The FFT chain leaves one array layer per band, N x N
+// RGBA = (h, dx, dz, d dx / dz) plus the derivative map beside it, and each band repeats with its
+// own patch size, so the sum only tiles at the least common multiple of the patches. Sampled through the REPEAT / LINEAR fftSampler
+// with an explicit mip: `footprint` is the size in meters of what one sample has to cover (one
+// pixel, see pixelFootprint), so far and small patches read the small, cache resident mips.
+// The includer declares N (int). Per band vec4s come from Global: bandPatch (0 = unused),
+// bandDisp (weight), bandFade (fade out distance, 0 = never). The maps hold each band at a few
+// simulated times, one layer each, and bands keep their own (--band-rates updates slow bands less
+// often). `ring` (Global bandRing) column b picks two of band b's layers: x / y = layer of the
+// older / newer time, z = weight of the newer (0 = x alone), so every band lands on the current time.
+
+#define MAX_BANDS 4
+
+// meters covered by one pixel at distance dist; proj[1][1] = 1 / tan(fovy / 2), invRes.y = 1 / height
+float pixelFootprint(mat4 proj, vec2 invRes, float dist){
+    return dist * 2.0 * invRes.y / proj[1][1];
+}
+
+// mip whose texels (patch / N * 2^lod meters) match the footprint
+float bandLod(float patch, float footprint){
+    return max(log2(footprint * float(N) / patch), 0.0);
+}
+
+// hardware trilinear, wrapping at the patch edges; texel i sits at uv = i / N like the foam grid
+vec4 sampleBand(sampler2DArray tex, vec2 uv, float lod, vec4 ring){
+    vec2 st = uv + 0.5 / float(N);
+    vec4 a = textureLod(tex, vec3(st, ring.x), lod);
+    if (ring.z == 0.0) return a;
+    return mix(a, textureLod(tex, vec3(st, ring.y), lod), ring.z);
+}
+
+// bandFade weight: 1 near the camera, 0 past the fade distance
+float bandFadeWeight(float fadeDist, float dist){
+    return (fadeDist > 0.0) ? 1.0 - smoothstep(fadeDist * 0.3, fadeDist, dist) : 1.0;
+}
+
+vec4 bandWeights(vec4 bandDisp, vec4 bandFade, float dist){
+    vec4 w;
+    for (int b = 0; b < MAX_BANDS; ++b)
+        w[b] = bandDisp[b] * bandFadeWeight(bandFade[b], dist);
+    return w;
+}
+
+// weighted sum over the bands: x = dx, y = h, z = dz
+vec3 sampleBands(sampler2DArray tex, vec2 worldXZ, vec4 bandPatch, vec4 weight, float footprint, mat4 ring){
+    vec3 d = vec3(0.0);
+    for (int b = 0; b < MAX_BANDS; ++b){
+        if (bandPatch[b] <= 0.0 || weight[b] == 0.0) continue;
+        float lod = bandLod(bandPatch[b], footprint);
+        d += weight[b] * sampleBand(tex, worldXZ / bandPatch[b], lod, ring[b]).yxz;
+    }
+    return d;
+}
+
+float sampleBandsH(sampler2DArray tex, vec2 worldXZ, vec4 bandPatch, vec4 weight, float footprint, mat4 ring){
+    float h = 0.0;
+    for (int b = 0; b < MAX_BANDS; ++b){
+        if (bandPatch[b] <= 0.0 || weight[b] == 0.0) continue;
+        float lod = bandLod(bandPatch[b], footprint);
+        h += weight[b] * sampleBand(tex, worldXZ / bandPatch[b], lod, ring[b]).x;
+    }
+    return h;
+}
+
+// (dh/dx, dh/dz) of the weighted sum, from the derivative map (per meter, see disp_pack.comp)
+vec2 sampleBandsSlope(sampler2DArray deriv, vec2 worldXZ, vec4 bandPatch, vec4 weight, float footprint, mat4 ring){
+    vec2 g = vec2(0.0);
+    for (int b = 0; b < MAX_BANDS; ++b){
+        if (bandPatch[b] <= 0.0 || weight[b] == 0.0) continue;
+        float lod = bandLod(bandPatch[b], footprint);
+        g += weight[b] * sampleBand(deriv, worldXZ / bandPatch[b], lod, ring[b]).xy;
+    }
+    return g;
+}
+
+#endif
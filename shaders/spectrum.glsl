@@ -0,0 +1,142 @@
+#ifndef SPECTRUM_GLSL
+#define SPECTRUM_GLSL
+
+// Phillips spectrum with hashed Gaussian amplitudes, shared by spectrum_init.comp, spectrum.comp and
+// the fused FFT path. Every band is one image array layer with its own patch size.
+// The includer defines N (int or uint).
+
+#include "complex.glsl"
+
+#ifndef PI
+#define PI 3.141592653589793
+#endif
+#define G  9.81
+
+// amplitudes were tuned on a 512 m patch; other patches are rescaled so a wave of a given
+// wavelength keeps its height whichever band it ends up in
+#define PATCH_REF 512.0
+
+uint hash_u32(uint x){
+    x ^= x >> 16;
+    x *= 0x7feb352du;
+    x ^= x >> 15;
+    x *= 0x846ca68bu;
+    x ^= x >> 16;
+    return x;
+}
+float hash01(uvec2 p, uint seed){
+    uint h = hash_u32(p.x * 1664525u + p.y * 1013904223u + seed);
+    return float(h) / 4294967296.0;
+}
+
+// Box-Muller Gaussian
+vec2 gaussian(uvec2 p, uint baseSeed){
+    float u1 = max(1e-6, hash01(p, baseSeed + 0u));
+    float u2 = hash01(p, baseSeed + 1u);
+    float r = sqrt(-2.0 * log(u1));
+    float th = 2.0 * PI * u2;
+    return r * vec2(cos(th), sin(th));
+}
+
+float phillips(vec2 k, vec2 wdir, float wSpeed, float A){
+    float klen = length(k);
+    if (klen < 1e-6) return 0.0;
+
+    float k2 = klen*klen;
+    float k4 = k2*k2;
+
+    float L  = (wSpeed*wSpeed) / G;
+    float L2 = L*L;
+
+    vec2 kh = k / klen;
+    float kw = dot(kh, wdir);
+
+    float damping = 0.001;
+    float l2 = (L * damping) * (L * damping);
+
+    float P = A * exp(-1.0 / (k2 * L2)) / k4 * (kw*kw) * exp(-k2 * l2);
+    float cap = exp(-k2 * 0.0005);
+    return P * cap;
+}
+
+// wave vector for texel id, frequency 0 at texel 0
+vec2 waveVector(ivec2 id, float patchSize){
+    const int n = int(N);
+    int ix = (id.x < n/2) ? id.x : (id.x - n);
+    int iy = (id.y < n/2) ? id.y : (id.y - n);
+    return 2.0 * PI * vec2(float(ix), float(iy)) / patchSize;
+}
+
+// time independent part of H: (h0(k), conj(h0(-k))). Only kMin <= |k| < kMax is kept (kMax <= 0
+// means no upper bound), so cascades of one sea state split the spectrum instead of doubling it.
+vec4 spectrumH0(ivec2 id, vec2 wind, float amp, float windSpeed, float patchSize, uint baseSeed,
+                float kMin, float kMax){
+    vec2 k = waveVector(id, patchSize);
+    float klen = length(k);
+
+    vec2 wdir = normalize(wind);
+    float P = phillips(k, wdir, windSpeed, amp);
+    if (klen < kMin || (kMax > 0.0 && klen >= kMax)) P = 0.0;
+
+    float norm = PATCH_REF / patchSize;
+
+    // independent complex Gaussians for k and -k
+    uvec2 uid  = uvec2(id);
+    const uint un = uint(N);
+    uvec2 uidm = uvec2((un - uint(id.x)) & (un-1u), (un - uint(id.y)) & (un-1u));
+
+    vec2 gk  = gaussian(uid,  baseSeed);
+    vec2 gmk = gaussian(uidm ^ uvec2(17u, 53u), baseSeed ^ 0x9e3779b9u);
+
+    vec2 H0k  = gk  * sqrt(max(P, 0.0) * 0.5) * norm;
+    vec2 H0mk = gmk * sqrt(max(P, 0.0) * 0.5) * norm;
+
+    return vec4(H0k, cconj(H0mk));
+}
+
+// deep water dispersion
+float dispersion(vec2 k){
+    return sqrt(G * length(k));
+}
+
+// H(k, t) = h0(k) e^{iwt} + conj(h0(-k)) e^{-iwt}
+vec2 evolveH(vec4 h0, float w, float t){
+    float wt = w * t;
+    vec2 eiwt = vec2(cos(wt), sin(wt));
+    return cmul(h0.xy, eiwt) + cmul(h0.zw, cconj(eiwt));
+}
+
+// texel of -k
+ivec2 mirrorTexel(ivec2 id){
+    const int n = int(N);
+    return ivec2((n - id.x) & (n - 1), (n - id.y) & (n - 1));
+}
+
+// Hermitian part (H(k) + conj(H(-k))) / 2, the part whose transform is real. The Nyquist row and
+// column are their own mirror and would leak between the two fields of a tile, so they are dropped
+vec2 hermitianH(ivec2 id, vec2 Hk, vec2 Hmk){
+    const int n = int(N);
+    if (id.x == n / 2 || id.y == n / 2) return vec2(0.0);
+    return 0.5 * (Hk + cconj(Hmk));
+}
+
+// The eight real fields the FFT produces per band, as spectra of the Hermitian H:
+//   h = H, Dx = i kx/|k| H, Dz = i kz/|k| H, dh/dx = i kx H, dh/dz = i kz H,
+//   dDx/dx = -kx^2/|k| H, dDz/dz = -kz^2/|k| H, dDx/dz = -kx kz/|k| H
+// Every one is Hermitian, so its transform is real and two of them share a complex tile
+// (first + i * second), each tile coming back out as (re, im) = (first, second):
+//   0 (h, Dx), 1 (Dz, dh/dx), 2 (dh/dz, dDx/dx), 3 (dDz/dz, dDx/dz)
+#define FIELD_TILES 4
+
+void fieldTiles(ivec2 id, vec2 Hh, float patchSize, out vec2 T[FIELD_TILES]){
+    vec2 k = waveVector(id, patchSize);
+    float klen = length(k);
+    vec2 kh = (klen < 1e-6) ? vec2(0.0) : k / klen;
+    vec2 iH = mulI(Hh);
+    T[0] = Hh                 + mulI(iH * kh.x);
+    T[1] = iH * kh.y          + mulI(iH * k.x);
+    T[2] = iH * k.y           + mulI(-Hh * (k.x * kh.x));
+    T[3] = -Hh * (k.y * kh.y) + mulI(-Hh * (k.x * kh.y));
+}
+
+#endif
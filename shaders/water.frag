@@ -1,9 +1,9 @@
 #version 450
+#extension GL_GOOGLE_include_directive : require
 
 layout(location=0) in vec3 vPos;
 layout(location=1) in vec2 vUV;
 layout(location=2) in vec2 vWorldXZ;
-layout(location=3) in vec2 vUVFFT;
 
 layout(location=0) out vec4 outColor;
 
@@ -18,22 +18,26 @@ layout(set=0, binding=0) uniform Global {
     vec4 screen;           // invRes.xy, nearZ, farZ
     vec4 boat0;            // boatPos.x, boatPos.z, boatYaw(rad), wakePatch
     vec4 boat1;            // boatSpeed, boatLen, boatWid, draft
+    vec4 bandPatch;        // per band patch size, 0 = unused
+    vec4 bandDisp;         // per band displacement weight
+    vec4 bandNormal;       // per band extra normal weight
+    vec4 bandFade;         // per band fade out distance, 0 = never
+    mat4 bandRing;         // per band simulated layers to blend, see ocean_bands.glsl
 } u;
 
-layout(set=1, binding=0) uniform sampler2D uFFT;       
+layout(set=1, binding=0) uniform sampler2DArray uFFT;  // one layer per band
 layout(set=1, binding=1) uniform sampler2D uEnvHDR;
 layout(set=1, binding=2) uniform sampler2D uFoam;
 layout(set=1, binding=3) uniform sampler2D uSceneColor;
 layout(set=1, binding=4) uniform sampler2D uSceneDepth;
-layout(set=1, binding=5) uniform sampler2D uFFTDetail;  
+layout(set=1, binding=5) uniform sampler2DArray uDeriv; // slopes + Jacobian terms, per band
 layout(set=1, binding=6) uniform sampler2D uWake;       
 
 #define PI 3.141592653589793
 
-const int N = 256;
+layout(constant_id = 0) const int N = 256;
 
-mat2 rot2(float a);
-vec2 macroWarp(vec2 worldXZ, float freq, float amp);
+#include "ocean_bands.glsl"
 
 vec2 wrap01(vec2 uv){
     vec2 f = fract(uv);
@@ -42,127 +46,6 @@ vec2 wrap01(vec2 uv){
     return f;
 }
 
-float texelTile(sampler2D tex, int tile, int x, int y){
-    int ix = tile * N + x;
-    return texelFetch(tex, ivec2(ix, y), 0).r;
-}
-
-float sampleReal(sampler2D tex, int tile, vec2 uv){
-    vec2 w = wrap01(uv);
-    float fx = w.x * float(N);
-    float fy = w.y * float(N);
-
-    int x0 = int(floor(fx)) % N;
-    int y0 = int(floor(fy)) % N;
-
-    float tx = fx - floor(fx);
-    float ty = fy - floor(fy);
-
-    int x1 = (x0 + 1) % N;
-    int y1 = (y0 + 1) % N;
-
-    float a = texelTile(tex, tile, x0, y0);
-    float b = texelTile(tex, tile, x1, y0);
-    float c = texelTile(tex, tile, x0, y1);
-    float d = texelTile(tex, tile, x1, y1);
-
-    float ab = mix(a, b, tx);
-    float cd = mix(c, d, tx);
-    return mix(ab, cd, ty);
-}
-
-float sampleH_comb(vec2 uv){ return sampleReal(uFFT, 0, uv); }
-float sampleH_wind(vec2 uv){ return sampleReal(uFFTDetail, 0, uv); }
-
-// sample the same FFT at multiple world patch sizes and blend by distance 
-struct CascadeW { float n; float m; float f; };
-
-CascadeW cascadeWeights(float dist){
-    CascadeW w;
-    w.n = 1.0 - smoothstep(250.0, 1400.0, dist);
-    w.m = smoothstep(450.0, 1400.0, dist) * (1.0 - smoothstep(2600.0, 9000.0, dist));
-    w.f = 1.0 - w.n - w.m;
-    w.f = clamp(w.f, 0.0, 1.0);
-    w.f = max(w.f, 0.18);
-    float s = max(1e-5, w.n + w.m + w.f);
-    w.n /= s; w.m /= s; w.f /= s;
-    return w;
-}
-
-void cascadeUVs(vec2 worldXZ, float basePatch, out vec2 uvFar, out vec2 uvMid, out vec2 uvNear){
-    float patchNear = basePatch * 1.0;
-    float patchMid  = basePatch * 4.0;
-    float patchFar  = basePatch * 16.0;
-
-    // cascade warp 
-    vec2 warpFar  = macroWarp(worldXZ * 0.35, 0.00035, 18.0) * 3.0;
-    vec2 warpMid  = macroWarp(worldXZ * 0.70, 0.00035, 18.0) * 1.6;
-    vec2 warpNear = macroWarp(worldXZ * 1.25, 0.00035, 18.0) * 0.8;
-
-    uvFar  = (rot2( 0.12) * (worldXZ + warpFar))  / patchFar;
-    uvMid  = (rot2( 0.35) * (worldXZ + warpMid))  / patchMid;
-    uvNear = (rot2(-0.75) * (worldXZ + warpNear)) / patchNear;
-}
-
-float sampleH_cascade_comb(vec2 worldXZ, float dist, float basePatch){
-    CascadeW w = cascadeWeights(dist);
-    vec2 uvF, uvM, uvN;
-    cascadeUVs(worldXZ, basePatch, uvF, uvM, uvN);
-    float hF = sampleH_comb(uvF) * 1.65;
-    float hM = sampleH_comb(uvM) * 1.00;
-    float hN = sampleH_comb(uvN) * 0.55;
-    return hF*w.f + hM*w.m + hN*w.n;
-}
-
- // wind shouldn't contribute far
-float sampleH_cascade_wind(vec2 worldXZ, float dist, float basePatch){
-    CascadeW w = cascadeWeights(dist);
-    vec2 uvF, uvM, uvN;
-    cascadeUVs(worldXZ, basePatch, uvF, uvM, uvN);
-    float wN = w.n;
-    float wM = w.m;
-    float s = max(1e-5, wN + wM);
-    wN/=s; wM/=s;
-    float hM = sampleH_wind(uvM) * 0.90;
-    float hN = sampleH_wind(uvN) * 1.10;
-    return hM*wM + hN*wN;
-}
-
-mat2 rot2(float a){
-    float c = cos(a), s = sin(a);
-    return mat2(c, -s, s, c);
-}
-
-
-uint hash_u32(uint x){
-    x ^= x >> 16;
-    x *= 0x7feb352du;
-    x ^= x >> 15;
-    x *= 0x846ca68bu;
-    x ^= x >> 16;
-    return x;
-}
-float hash01(ivec2 p){
-    uint h = hash_u32(uint(p.x) * 1664525u + uint(p.y) * 1013904223u + 1337u);
-    return float(h) / 4294967296.0;
-}
-float valueNoise(vec2 p){
-    ivec2 i = ivec2(floor(p));
-    vec2 f = fract(p);
-    vec2 u = f*f*(3.0-2.0*f);
-    float a = hash01(i + ivec2(0,0));
-    float b = hash01(i + ivec2(1,0));
-    float c = hash01(i + ivec2(0,1));
-    float d = hash01(i + ivec2(1,1));
-    return mix(mix(a,b,u.x), mix(c,d,u.x), u.y);
-}
-vec2 macroWarp(vec2 worldXZ, float freq, float amp){
-    vec2 p = worldXZ * freq;
-    float n1 = valueNoise(p);
-    float n2 = valueNoise(p + vec2(19.7, 7.3));
-    vec2 n = vec2(n1, n2) * 2.0 - 1.0;
-    return n * amp; 
-}
 vec2 dirToEquirectUV(vec3 d){
     d = normalize(d);
     float u0 = atan(d.z, d.x);
@@ -205,7 +88,6 @@ vec2 rippleGrad(vec2 worldXZ, float t){
 }
 
 void main(){
-    float patchSize   = u.wave0.x;
     float heightScale = u.wave0.y;
     float swellAmp    = u.wave0.w;
     float dayNight    = u.wave1.y;
@@ -225,36 +107,20 @@ void main(){
     float windFade   = 1.0 - smoothstep(900.0, 3200.0, dist);
     float rippleFade = 1.0 - smoothstep(250.0, 1400.0, dist);
 
-    // --- Base normal from cascaded displacement (true cascades) ---
-    float stepW = patchSize / float(N);
-
-    // Sample cascaded height in world space (avoids UV-wrap discontinuities)
-    float hL = sampleH_cascade_comb(vWorldXZ - vec2(stepW, 0.0), dist, patchSize) * heightScale;
-    float hR = sampleH_cascade_comb(vWorldXZ + vec2(stepW, 0.0), dist, patchSize) * heightScale;
-    float hD = sampleH_cascade_comb(vWorldXZ - vec2(0.0, stepW), dist, patchSize) * heightScale;
-    float hU = sampleH_cascade_comb(vWorldXZ + vec2(0.0, stepW), dist, patchSize) * heightScale;
+    // --- Base normal from the bands' slopes, each at its own mip ---
+    // bandNormal adds normal-only weight on top (wind detail, stronger than displacement)
+    vec4 bandW = bandWeights(u.bandDisp, u.bandFade, dist);
+    float footprint = pixelFootprint(u.proj, invRes, length(vec2(dist, u.cameraPos_time.y)));
+    vec4 gradW = bandW + u.bandNormal * windFade;
+    vec2 gBands = sampleBandsSlope(uDeriv, vWorldXZ, u.bandPatch, gradW, footprint, u.bandRing) * heightScale;
 
     // Same swell phase as water.vert
     float phase = 0.015 * (vWorldXZ.x + vWorldXZ.y) + u.cameraPos_time.w * u.wave1.x;
     float swell = swellAmp * sin(phase);
     float ds = swellAmp * 0.015 * cos(phase);
 
-    float dhdx = (hR - hL) / (2.0 * stepW) + ds;
-    float dhdz = (hU - hD) / (2.0 * stepW) + ds;
-
-    // --- Wind-band normals (cascade-aware, stronger than displacement) ---
-    const float WIND_NORM_SCALE = 0.90;
-
-    float wL = sampleH_cascade_wind(vWorldXZ - vec2(stepW, 0.0), dist, patchSize) * heightScale;
-    float wR = sampleH_cascade_wind(vWorldXZ + vec2(stepW, 0.0), dist, patchSize) * heightScale;
-    float wD = sampleH_cascade_wind(vWorldXZ - vec2(0.0, stepW), dist, patchSize) * heightScale;
-    float wU = sampleH_cascade_wind(vWorldXZ + vec2(0.0, stepW), dist, patchSize) * heightScale;
-
-    float dhdxW = (wR - wL) / (2.0 * stepW);
-    float dhdzW = (wU - wD) / (2.0 * stepW);
-
-    dhdx += dhdxW * (WIND_NORM_SCALE * windFade);
-    dhdz += dhdzW * (WIND_NORM_SCALE * windFade);
+    float dhdx = gBands.x + ds;
+    float dhdz = gBands.y + ds;
 
     // --- Ripples (normal-only) ---
     vec2 gRip = rippleGrad(vWorldXZ, u.cameraPos_time.w);
@@ -264,7 +130,7 @@ void main(){
     vec3 n = normalize(vec3(-dhdx, 1.0, -dhdz));
 
     if (dbg == 1){
-        float h = sampleH_cascade_comb(vWorldXZ, dist, patchSize) * heightScale;
+        float h = sampleBandsH(uFFT, vWorldXZ, u.bandPatch, bandW, footprint, u.bandRing) * heightScale;
         outColor = vec4(vec3(0.5 + 0.02*h), 1.0);
         return;
     }
@@ -281,7 +147,7 @@ void main(){
     float fres = F0 + (1.0 - F0) * pow(1.0 - NdotV, 5.0);
 
     // Foam (temporal sim texture)
-    // Foam uses stable base UV (not the warped FFT UV), so it doesn't look screen-locked.
+    // Foam uses stable base UV, so it doesn't look screen-locked.
     float foam = texture(uFoam, wrap01(vUV)).r;
     // Boat wake (local patch around boat). Stored in a separate R16F field for long trails.
     vec2 boatXZ = u.boat0.xy;
@@ -319,7 +185,7 @@ void main(){
     vec3 deepCol    = mix(deepNight,    deepDay,    dayNight);
     vec3 shallowCol = mix(shallowNight, shallowDay, dayNight);
 
-    float hNow = sampleH_cascade_comb(vWorldXZ, dist, patchSize) * heightScale + swell;
+    float hNow = sampleBandsH(uFFT, vWorldXZ, u.bandPatch, bandW, footprint, u.bandRing) * heightScale + swell;
 
     float crest = clamp(1.0 - exp(-abs(hNow) * 0.02), 0.0, 1.0);
     float grazing = pow(1.0 - NdotV, 2.0);
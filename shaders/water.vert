@@ -1,8 +1,9 @@
 #version 450
+#extension GL_GOOGLE_include_directive : require
 
-layout(location=0) in vec2 inXZ;
-layout(location=1) in vec2 inUV;
-layout(location=2) in float inSkirt;
+#ifndef VERTEXLESS
+layout(location=0) in uvec2 inGrid; // column, row of the mesh grid; bit 15 of the row on skirt vertices
+#endif
 
 layout(set=0, binding=0) uniform Global {
     mat4 view;
@@ -13,100 +14,83 @@ layout(set=0, binding=0) uniform Global {
     vec4 wave1;            // swellSpeed, dayNight, envExposure, envMaxMip
     ivec4 debug;
     vec4 screen;           // invRes.xy, nearZ, farZ
+    vec4 boat0;            // boatPos.x, boatPos.z, boatYaw(rad), wakePatch
+    vec4 boat1;            // boatSpeed, boatLen, boatWid, draft
+    vec4 bandPatch;        // per band patch size, 0 = unused
+    vec4 bandDisp;         // per band displacement weight
+    vec4 bandNormal;       // per band extra normal weight (fragment only)
+    vec4 bandFade;         // per band fade out distance, 0 = never
+    mat4 bandRing;         // per band simulated layers to blend, see ocean_bands.glsl
 } u;
 
 layout(push_constant) uniform PC {
-    vec2 worldOffset; 
-    vec2 _pad;
+    vec2 worldOffset; // worldOrigin
+    uint nodeBase;    // this frame's range of uNodes
+    int oceanRadius;  // tiles around worldOrigin, 0 = the single tile of the finite ocean
 } pc;
 
-layout(set=1, binding=0) uniform sampler2D uFFT;
+layout(set=1, binding=0) uniform sampler2DArray uFFT; // one layer per band
 
-layout(location=0) out vec3 vPos;
-layout(location=1) out vec2 vUV;       // base UV
-layout(location=2) out vec2 vWorldXZ;
-layout(location=3) out vec2 vUVFFT;    // warped UV for FFT sampling 
+// visible CDLOD nodes from water_cull.comp (or the CPU ring with --cpu-tiles): xy = node center
+// relative to worldOrigin, z = size, w = distance its level is fully morphed at (0 = coarsest)
+layout(std430, set=1, binding=7) readonly buffer Nodes {
+    vec4 uNodes[];
+};
 
-#define PI 3.141592653589793
+// set from the host constants of the same name (WaterSpecData)
+layout(constant_id = 3) const float NODE_GRID   = 32.0;  // kWaterNodeGrid, cells per node side
+layout(constant_id = 4) const float PROJ_GRID   = 384.0; // kProjectedGrid
+layout(constant_id = 5) const float MORPH_START = 0.7;   // kWaterMorphStart
+layout(constant_id = 6) const float SKIRT_DEPTH = 250.0; // kWaterSkirtDepth
+const uint  SKIRT_BIT   = 0x8000u; // kMeshVertSkirt
 
-// width = 3*N, height = N
-// tile 0 = height, tile 1 = choppy dx, tile 2 = choppy dz
-const int N = 256;
-
-// break far repition
-uint hash_u32(uint x){
-    x ^= x >> 16;
-    x *= 0x7feb352du;
-    x ^= x >> 15;
-    x *= 0x846ca68bu;
-    x ^= x >> 16;
-    return x;
-}
-
-float hash01(ivec2 p){
-    uint h = hash_u32(uint(p.x) * 1664525u + uint(p.y) * 1013904223u + 1337u);
-    return float(h) / 4294967296.0;
-}
-
-float valueNoise(vec2 p){
-    ivec2 i = ivec2(floor(p));
-    vec2 f = fract(p);
-    vec2 u = f*f*(3.0-2.0*f);
-    float a = hash01(i + ivec2(0,0));
-    float b = hash01(i + ivec2(1,0));
-    float c = hash01(i + ivec2(0,1));
-    float d = hash01(i + ivec2(1,1));
-    return mix(mix(a,b,u.x), mix(c,d,u.x), u.y);
-}
-
-vec2 macroWarp(vec2 worldXZ){
-    vec2 p = worldXZ * 0.00035;
-    float n1 = valueNoise(p);
-    float n2 = valueNoise(p + vec2(19.7, 7.3));
-    vec2 n = vec2(n1, n2) * 2.0 - 1.0;
-    return n * 18.0;
-}
-
-vec2 wrap01(vec2 uv){
-    vec2 f = fract(uv);
-    const float eps = 1e-6;
-    f = mix(f, vec2(0.0), greaterThan(f, vec2(1.0 - eps)));
-    return f;
-}
+// projected grid mode: inXZ is a point of the screen instead of a node, no uNodes
+layout(constant_id = 1) const bool PROJECTED = false;
+const float PROJ_MARGIN = 1.15; // screen grid past the edges, for the horizontal displacement
 
-float texelTile(int tile, int x, int y){
-    int ix = tile * N + x;
-    return texelFetch(uFFT, ivec2(ix, y), 0).r;
-}
+// tessellated mode: only place the flat node grid, vPos = (x, skirt drop, z) in render space;
+// water.tesc subdivides it and water.tese displaces
+layout(constant_id = 2) const bool TESSELLATED = false;
 
-float sampleReal(int tile, vec2 uv){
-    vec2 w = wrap01(uv);
-    float fx = w.x * float(N);
-    float fy = w.y * float(N);
+layout(location=0) out vec3 vPos;
+layout(location=1) out vec2 vUV;       // base UV
+layout(location=2) out vec2 vWorldXZ;
 
-    int x0 = int(floor(fx)) % N;
-    int y0 = int(floor(fy)) % N;
+// --depth-prepass draws with the same stages but no water.frag, then tests EQUAL
+invariant gl_Position;
 
-    float tx = fx - floor(fx);
-    float ty = fy - floor(fy);
+#define PI 3.141592653589793
 
-    int x1 = (x0 + 1) % N;
-    int y1 = (y0 + 1) % N;
+// N x N per band, (h, choppy dx, choppy dz, d dx / dz)
+layout(constant_id = 0) const int N = 256;
 
-    float a = texelTile(tile, x0, y0);
-    float b = texelTile(tile, x1, y0);
-    float c = texelTile(tile, x0, y1);
-    float d = texelTile(tile, x1, y1);
+#include "ocean_bands.glsl"
 
-    float ab = mix(a, b, tx);
-    float cd = mix(c, d, tx);
-    return mix(ab, cd, ty);
+// the ray through a point of the screen grid onto the sea plane, in render space. Rays at or above
+// the horizon are tilted down to meet it at the far plane
+vec2 projectToSea(vec2 grid){
+    vec2 ndc = grid * 2.0 * PROJ_MARGIN;
+    vec3 dir = transpose(mat3(u.view)) * vec3(ndc.x / u.proj[0][0], ndc.y / u.proj[1][1], -1.0);
+    float height = max(u.cameraPos_time.y, 1.0);
+    dir.y = min(dir.y, -height * length(dir.xz) / u.screen.w);
+    return u.cameraPos_time.xz + dir.xz * (height / -dir.y);
 }
 
-mat2 rot2(float a){
-    float c = cos(a), s = sin(a);
-    return mat2(c, -s, s, c);
+#ifdef VERTEXLESS
+// --vertexless (water.vert.vertexless.spv): no vertex buffer, the index is the vertex. The (n + 1)^2
+// grid vertices row by row, then (node mesh only) the 4 n skirt vertices around the edge,
+// counter-clockwise from (0, 0), as buildWaterMesh numbers them
+uvec2 gridVertex(uint v, uint n){
+    uint side = n + 1u;
+    if (v < side * side) return uvec2(v % side, v / side);
+    uint p = v - side * side;
+    uvec2 g = (p < n)      ? uvec2(p, 0u)
+            : (p < 2u * n) ? uvec2(n, p - n)
+            : (p < 3u * n) ? uvec2(3u * n - p, n)
+            :                uvec2(0u, 4u * n - p);
+    return uvec2(g.x, g.y | SKIRT_BIT);
 }
+#endif
 
 void main(){
     float patchSize   = u.wave0.x;   
@@ -117,58 +101,62 @@ void main(){
 
     vec2 worldOrigin = u.worldOrigin_pad.xy;
 
+    // the vertex on the unit grid, -0.5..0.5
+#ifdef VERTEXLESS
+    uvec2 inGrid = gridVertex(uint(gl_VertexIndex), uint(PROJECTED ? PROJ_GRID : NODE_GRID));
+#endif
+    vec2 grid = vec2(inGrid.x, inGrid.y & ~SKIRT_BIT);
+    vec2 inXZ = grid / (PROJECTED ? PROJ_GRID : NODE_GRID) - 0.5;
+    bool inSkirt = (inGrid.y & SKIRT_BIT) != 0u;
+
     // keep render cords near origin
-    vec2 tileLocal   = pc.worldOffset - worldOrigin;
-    vec2 localXZ     = inXZ + tileLocal;
+    vec2 localXZ;
+    if (PROJECTED) {
+        localXZ = projectToSea(inXZ);
+    } else {
+        // morph the odd rows / columns onto the even ones, into the grid of the next level, by the
+        // distance of the flat vertex (as water_cull.comp measures nodes). Fully morphed where a
+        // coarser node may start, so seams match without skirts
+        vec4 node = uNodes[pc.nodeBase + uint(gl_InstanceIndex)];
+        vec2 flatXZ = node.xy + inXZ * node.z;
+        float camDist = length(vec3(flatXZ.x, 0.0, flatXZ.y) - u.cameraPos_time.xyz);
+        float morph = node.w > 0.0 ? clamp((camDist / node.w - MORPH_START) / (1.0 - MORPH_START), 0.0, 1.0) : 0.0;
+        vec2 odd = fract(grid * 0.5) * 2.0;
+        localXZ = node.xy + (inXZ - odd * (morph / NODE_GRID)) * node.z;
+    }
 
-    vec2 worldXZ     = inXZ + pc.worldOffset;
+    vec2 worldXZ     = pc.worldOffset + localXZ;
+
+    // skirts only hang along the outer edge of the ocean: a metre outward lies in no tile
+    float skirtDrop = 0.0;
+    if (!PROJECTED && inSkirt) {
+        vec2 outward = vec2(equal(abs(inXZ), vec2(0.5))) * sign(inXZ);
+        vec2 t = floor((localXZ + outward) / patchSize + 0.5);
+        float rr = float(pc.oceanRadius) + 0.5;
+        if (dot(t, t) > rr * rr) {
+            skirtDrop = SKIRT_DEPTH;
+        }
+    }
+
+    if (TESSELLATED) {
+        vPos     = vec3(localXZ.x, -skirtDrop, localXZ.y);
+        vUV      = worldXZ / patchSize;
+        vWorldXZ = worldXZ;
+        gl_Position = vec4(vPos, 1.0);
+        return;
+    }
 
     // camera in absolute world coords
     vec2 camWorldXZ  = worldOrigin + u.cameraPos_time.xz;
     float dist       = length(worldXZ - camWorldXZ);
 
-    float patchNear = patchSize * 1.0;
-    float patchMid  = patchSize * 4.0;
-    float patchFar  = patchSize * 16.0;
-
-    float wNear = 1.0 - smoothstep(250.0, 1400.0, dist);
-    float wMid  = smoothstep(450.0, 1400.0, dist) * (1.0 - smoothstep(2600.0, 9000.0, dist));
-    float wFar  = 1.0 - wNear - wMid;
-    wFar = clamp(wFar, 0.0, 1.0);
-    wFar = max(wFar, 0.18);
-    float wSum = max(1e-5, wNear + wMid + wFar);
-    wNear /= wSum; wMid /= wSum; wFar /= wSum;
-
-    // cascade domain warp 
-    vec2 warpFar  = macroWarp(worldXZ * 0.35) * 3.0;
-    vec2 warpMid  = macroWarp(worldXZ * 0.70) * 1.6;
-    vec2 warpNear = macroWarp(worldXZ * 1.25) * 0.8;
-
-    vec2 uvFar  = (rot2( 0.12) * (worldXZ + warpFar))  / patchFar;
-    vec2 uvMid  = (rot2( 0.35) * (worldXZ + warpMid))  / patchMid;
-    vec2 uvNear = (rot2(-0.75) * (worldXZ + warpNear)) / patchNear;
-
-    //FFT tile0=H, tile1=dx, tile2=dz
-    float hFar  = sampleReal(0, uvFar);
-    float dxFar = sampleReal(1, uvFar);
-    float dzFar = sampleReal(2, uvFar);
-
-    float hMid  = sampleReal(0, uvMid);
-    float dxMid = sampleReal(1, uvMid);
-    float dzMid = sampleReal(2, uvMid);
-
-    float hNear  = sampleReal(0, uvNear);
-    float dxNear = sampleReal(1, uvNear);
-    float dzNear = sampleReal(2, uvNear);
-
-    // scale amplitudes per cascade 
-    hFar  *= 1.65; dxFar *= 1.65; dzFar *= 1.65;
-    hMid  *= 1.00; dxMid *= 1.00; dzMid *= 1.00;
-    hNear *= 0.55; dxNear *= 0.55; dzNear *= 0.55;
-
-    float h  = hFar  * wFar + hMid  * wMid + hNear  * wNear;
-    float dx = dxFar * wFar + dxMid * wMid + dxNear * wNear;
-    float dz = dzFar * wFar + dzMid * wMid + dzNear * wNear;
+    // every band at its own patch size, no resampling of a single patch
+    vec4 bandW = bandWeights(u.bandDisp, u.bandFade, dist);
+    float footprint = pixelFootprint(u.proj, u.screen.xy, length(vec2(dist, u.cameraPos_time.y)));
+    vec3 d = sampleBands(uFFT, worldXZ, u.bandPatch, bandW, footprint, u.bandRing);
+    float dx = d.x;
+    float h  = d.y;
+    float dz = d.z;
 
     // analytic swell 
     float swell = swellAmp * sin(0.015 * (worldXZ.x + worldXZ.y) + u.cameraPos_time.w * swellSpeed);
@@ -176,11 +164,7 @@ void main(){
     vec3 pos;
     pos.x = localXZ.x + choppy * dx;
     pos.z = localXZ.y + choppy * dz;
-    pos.y = h * heightScale + swell;
-
-    if (inSkirt > 0.5) {
-        pos.y -= 250.0; // skirt depth
-    }
+    pos.y = h * heightScale + swell - skirtDrop;
 
     vec2 uvBase = worldXZ / patchSize;
 
@@ -188,7 +172,5 @@ void main(){
     vUV      = uvBase;
     vWorldXZ = worldXZ;
 
-    vUVFFT   = uvNear;
-
     gl_Position = u.proj * u.view * vec4(pos, 1.0);
 }
@@ -0,0 +1,257 @@
+#include "gpu_profiler.h"
+
+#include <algorithm>
+#include <iomanip>
+#include <stdexcept>
+
+void GpuProfiler::init(VkPhysicalDevice phys, VkDevice device, uint32_t queueFamily, uint32_t framesInFlight,
+                       bool pipelineStatistics)
+{
+    uint32_t qCount = 0;
+    vkGetPhysicalDeviceQueueFamilyProperties(phys, &qCount, nullptr);
+    std::vector<VkQueueFamilyProperties> qProps(qCount);
+    vkGetPhysicalDeviceQueueFamilyProperties(phys, &qCount, qProps.data());
+
+    uint32_t validBits = (queueFamily < qCount) ? qProps[queueFamily].timestampValidBits : 0;
+    supported = validBits > 0;
+    // graphics statistics only count on a graphics queue
+    statsSupported = pipelineStatistics && queueFamily < qCount &&
+                     (qProps[queueFamily].queueFlags & VK_QUEUE_GRAPHICS_BIT) != 0;
+    if (!supported && !statsSupported)
+        return;
+
+    if (supported)
+    {
+        validMask = (validBits >= 64) ? ~0ull : ((1ull << validBits) - 1ull);
+
+        VkPhysicalDeviceProperties props{};
+        vkGetPhysicalDeviceProperties(phys, &props);
+        nsPerTick = (double)props.limits.timestampPeriod;
+    }
+
+    frames.resize(framesInFlight);
+    for (auto &f : frames)
+    {
+        if (supported)
+        {
+            VkQueryPoolCreateInfo qi{VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO};
+            qi.queryType = VK_QUERY_TYPE_TIMESTAMP;
+            qi.queryCount = kMaxScopesPerFrame * 2;
+            if (vkCreateQueryPool(device, &qi, nullptr, &f.pool) != VK_SUCCESS)
+                throw std::runtime_error("vkCreateQueryPool failed");
+        }
+        if (statsSupported)
+        {
+            VkQueryPoolCreateInfo qi{VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO};
+            qi.queryType = VK_QUERY_TYPE_PIPELINE_STATISTICS;
+            qi.queryCount = kMaxStatsPerFrame;
+            qi.pipelineStatistics = VK_QUERY_PIPELINE_STATISTIC_FRAGMENT_SHADER_INVOCATIONS_BIT;
+            if (vkCreateQueryPool(device, &qi, nullptr, &f.statsPool) != VK_SUCCESS)
+                throw std::runtime_error("vkCreateQueryPool(pipeline statistics) failed");
+        }
+    }
+}
+
+void GpuProfiler::cleanup(VkDevice device)
+{
+    for (auto &f : frames)
+    {
+        if (f.pool)
+            vkDestroyQueryPool(device, f.pool, nullptr);
+        if (f.statsPool)
+            vkDestroyQueryPool(device, f.statsPool, nullptr);
+    }
+    frames.clear();
+    if (csv.is_open())
+        csv.close();
+}
+
+void GpuProfiler::openCsv(const std::string &path)
+{
+    csv.open(path, std::ios::trunc);
+    if (!csv)
+        throw std::runtime_error("cannot open " + path);
+    csv << "frame,pass,ms\n";
+}
+
+void GpuProfiler::beginFrame(VkDevice device, VkCommandBuffer cmd, uint32_t slot)
+{
+    if (!supported && !statsSupported)
+        return;
+
+    cur = slot % (uint32_t)frames.size();
+    Frame &f = frames[cur];
+    if (f.pending)
+        collect(device, f);
+
+    f.scopeOfPair.clear();
+    f.scopeOfStat.clear();
+    f.pending = false;
+    openPairs.clear();
+    openStat = UINT32_MAX;
+    if (f.pool)
+        vkCmdResetQueryPool(cmd, f.pool, 0, kMaxScopesPerFrame * 2);
+    if (f.statsPool)
+        vkCmdResetQueryPool(cmd, f.statsPool, 0, kMaxStatsPerFrame);
+}
+
+void GpuProfiler::begin(VkCommandBuffer cmd, const char *name)
+{
+    if (!supported)
+        return;
+
+    Frame &f = frames[cur];
+    if (f.scopeOfPair.size() >= kMaxScopesPerFrame)
+    {
+        // keep begin/end balanced even when out of queries
+        openPairs.push_back(UINT32_MAX);
+        return;
+    }
+
+    uint32_t pair = (uint32_t)f.scopeOfPair.size();
+    f.scopeOfPair.push_back(scopeIndex(scopes, name));
+    openPairs.push_back(pair);
+    f.pending = true;
+    vkCmdWriteTimestamp(cmd, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, f.pool, pair * 2);
+}
+
+void GpuProfiler::end(VkCommandBuffer cmd)
+{
+    if (!supported || openPairs.empty())
+        return;
+
+    uint32_t pair = openPairs.back();
+    openPairs.pop_back();
+    if (pair == UINT32_MAX)
+        return;
+
+    vkCmdWriteTimestamp(cmd, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, frames[cur].pool, pair * 2 + 1);
+}
+
+void GpuProfiler::beginStats(VkCommandBuffer cmd, const char *name)
+{
+    if (!statsSupported || openStat != UINT32_MAX)
+        return;
+
+    Frame &f = frames[cur];
+    if (f.scopeOfStat.size() >= kMaxStatsPerFrame)
+        return;
+
+    openStat = (uint32_t)f.scopeOfStat.size();
+    f.scopeOfStat.push_back(scopeIndex(statScopes, name));
+    f.pending = true;
+    vkCmdBeginQuery(cmd, f.statsPool, openStat, 0);
+}
+
+void GpuProfiler::endStats(VkCommandBuffer cmd)
+{
+    if (!statsSupported || openStat == UINT32_MAX)
+        return;
+
+    vkCmdEndQuery(cmd, frames[cur].statsPool, openStat);
+    openStat = UINT32_MAX;
+}
+
+static void addSample(GpuProfiler::Scope &s, float v)
+{
+    s.samples[s.next] = v;
+    s.next = (s.next + 1) % GpuProfiler::kHistory;
+    s.count = std::min(s.count + 1, GpuProfiler::kHistory);
+}
+
+void GpuProfiler::collect(VkDevice device, Frame &f)
+{
+    uint32_t queryCount = (uint32_t)f.scopeOfPair.size() * 2;
+    uint64_t ticks[kMaxScopesPerFrame * 2]{};
+    // no WAIT bit: the fence for this slot has signaled, anything not ready is simply dropped
+    if (queryCount > 0 &&
+        vkGetQueryPoolResults(device, f.pool, 0, queryCount, sizeof(ticks), ticks, sizeof(uint64_t),
+                              VK_QUERY_RESULT_64_BIT) == VK_SUCCESS)
+    {
+        for (uint32_t p = 0; p < (uint32_t)f.scopeOfPair.size(); ++p)
+        {
+            uint64_t t0 = ticks[p * 2] & validMask;
+            uint64_t t1 = ticks[p * 2 + 1] & validMask;
+            float ms = (float)((double)((t1 - t0) & validMask) * nsPerTick * 1e-6);
+
+            Scope &s = scopes[f.scopeOfPair[p]];
+            addSample(s, ms);
+
+            if (csv.is_open())
+                csv << collectedFrames << "," << s.name << "," << ms << "\n";
+        }
+    }
+
+    uint32_t statCount = (uint32_t)f.scopeOfStat.size();
+    uint64_t invocations[kMaxStatsPerFrame]{};
+    if (statCount > 0 &&
+        vkGetQueryPoolResults(device, f.statsPool, 0, statCount, sizeof(invocations), invocations, sizeof(uint64_t),
+                              VK_QUERY_RESULT_64_BIT) == VK_SUCCESS)
+    {
+        for (uint32_t q = 0; q < statCount; ++q)
+            addSample(statScopes[f.scopeOfStat[q]], (float)invocations[q]);
+    }
+    collectedFrames++;
+}
+
+uint32_t GpuProfiler::scopeIndex(std::vector<Scope> &list, const char *name)
+{
+    for (uint32_t i = 0; i < (uint32_t)list.size(); ++i)
+    {
+        if (list[i].name == name)
+            return i;
+    }
+    Scope s{};
+    s.name = name;
+    s.samples.assign(kHistory, 0.0f);
+    list.push_back(std::move(s));
+    return (uint32_t)list.size() - 1;
+}
+
+// one row per scope, samples times scale
+static void printScopes(std::ostream &os, const std::vector<GpuProfiler::Scope> &list, double scale)
+{
+    os << "  " << std::left << std::setw(18) << "pass" << std::right
+       << std::setw(9) << "min" << std::setw(9) << "avg" << std::setw(9) << "p99" << "\n";
+
+    std::vector<float> sorted;
+    for (const GpuProfiler::Scope &s : list)
+    {
+        if (s.count == 0)
+            continue;
+
+        sorted.assign(s.samples.begin(), s.samples.begin() + s.count);
+        std::sort(sorted.begin(), sorted.end());
+
+        double sum = 0.0;
+        for (float v : sorted)
+            sum += v;
+
+        size_t p99 = std::min(sorted.size() - 1, (size_t)(0.99 * (double)sorted.size()));
+
+        os << "  " << std::left << std::setw(18) << s.name << std::right << std::fixed << std::setprecision(3)
+           << std::setw(9) << sorted.front() * scale
+           << std::setw(9) << (sum / (double)sorted.size()) * scale
+           << std::setw(9) << sorted[p99] * scale << "\n";
+    }
+    os << std::defaultfloat;
+}
+
+void GpuProfiler::printSummary(std::ostream &os) const
+{
+    if (!supported)
+    {
+        os << "GPU timestamps not supported on this queue\n";
+    }
+    else
+    {
+        os << "GPU pass timings (ms, last " << kHistory << " frames)\n";
+        printScopes(os, scopes, 1.0);
+    }
+
+    if (statsSupported && !statScopes.empty())
+    {
+        os << "Fragment shader invocations (millions, last " << kHistory << " frames)\n";
+        printScopes(os, statScopes, 1e-6);
+    }
+}
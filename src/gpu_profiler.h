@@ -0,0 +1,78 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include <cstdint>
+#include <fstream>
+#include <ostream>
+#include <string>
+#include <vector>
+
+// GPU timestamp profiler. One query pool per frame in flight; a slot's results are read back
+// when the slot comes around again (its fence has already been waited on), so it never stalls.
+// Scopes may nest and are identified by name; each keeps a rolling window of samples in ms.
+// Optionally counts fragment shader invocations the same way (pipeline statistics queries), in
+// stats scopes that may not nest.
+struct GpuProfiler
+{
+    static constexpr uint32_t kMaxScopesPerFrame = 32;
+    static constexpr uint32_t kMaxStatsPerFrame = 8;
+    static constexpr uint32_t kHistory = 240;
+
+    struct Scope
+    {
+        std::string name;
+        std::vector<float> samples; // ring of kHistory
+        uint32_t next = 0;
+        uint32_t count = 0;
+    };
+
+    struct Frame
+    {
+        VkQueryPool pool{};
+        std::vector<uint32_t> scopeOfPair; // pair i = queries 2i, 2i+1
+        VkQueryPool statsPool{};
+        std::vector<uint32_t> scopeOfStat; // query i
+        bool pending = false;
+    };
+
+    bool supported = false;
+    bool statsSupported = false;
+    double nsPerTick = 1.0;
+    uint64_t validMask = ~0ull;
+
+    std::vector<Frame> frames;
+    std::vector<Scope> scopes;
+    std::vector<Scope> statScopes; // samples in fragment shader invocations
+    std::vector<uint32_t> openPairs;
+    uint32_t openStat = UINT32_MAX;
+    uint32_t cur = 0;
+    uint64_t collectedFrames = 0;
+
+    std::ofstream csv;
+
+    // pipelineStatistics: the device has the pipelineStatisticsQuery feature enabled
+    void init(VkPhysicalDevice phys, VkDevice device, uint32_t queueFamily, uint32_t framesInFlight,
+              bool pipelineStatistics = false);
+    void cleanup(VkDevice device);
+
+    // long format "frame,pass,ms", one row per scope per collected frame
+    void openCsv(const std::string &path);
+
+    // call right after the frame slot's fence wait, outside any render pass
+    void beginFrame(VkDevice device, VkCommandBuffer cmd, uint32_t slot);
+
+    void begin(VkCommandBuffer cmd, const char *name);
+    void end(VkCommandBuffer cmd);
+
+    // fragment shader invocations between the two; outside render passes or within one subpass
+    void beginStats(VkCommandBuffer cmd, const char *name);
+    void endStats(VkCommandBuffer cmd);
+
+    // min / avg / p99 per scope over the rolling window, then the same for the stats scopes
+    void printSummary(std::ostream &os) const;
+
+    // internal
+    void collect(VkDevice device, Frame &f);
+    static uint32_t scopeIndex(std::vector<Scope> &list, const char *name);
+};
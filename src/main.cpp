@@ -9,15 +9,22 @@
 #include <string>
 #include <array>
 #include <algorithm>
+#include <cmath>
+#include <cstddef>
 #include <cstdint>
 #include <cstdlib>
 #include <stdexcept>
 #include <cstring>
+#include <cstdio>
+#include <chrono>
+#include <fstream>
 
 #include "vk_context.h"
 #include "vk_helpers.h"
+#include "gpu_profiler.h"
 #include "hdr_loader.h"
 #include "obj_loader.h"
+#include "mesh_opt.h"
 
 namespace fs = std::filesystem;
 
@@ -43,14 +50,19 @@ static float gChoppy = 6.0f;
 static float gSwellAmp = 1.5f;
 static float gSwellSpeed = 0.25f;
 
+// spectrum shape, applied on top of each band's own wind / amplitude. changing any of these
+// rebuilds the cached h0(k) / w(k) images
+static float gWindAngle = 0.0f; // radians
+static float gWindSpeedScale = 1.0f;
+static float gSpectrumAmpScale = 1.0f;
+static bool gSpectrumDirty = true;
+
 static float dayNight = 1.0f;
 static bool wireframe = false;
 static int shaderDebug = 0;
 
 static bool infiniteOcean = true;
 static int oceanRadius = 12;
-static int lod0Radius = 2;
-static int lod1Radius = 5;
 
 static float cameraSpeedBase = 10.0f;
 
@@ -80,12 +92,92 @@ static float gDuckEdgeMargin = 10.0f;
 static float gExposure = 0.55f;
 static float gBloomStrength = 0.85f;
 
+// command line / headless run
+static bool gHeadless = false;
+static uint32_t gWidth = 1920;
+static uint32_t gHeight = 1080;
+static int gMaxFrames = 0;     // 0 = run until the window closes
+static float gFixedDt = 0.0f;  // 0 = wall clock
+static std::string gOutputPath;
+
+// fft kernels: the original radix-2 rows/cols, stockham radix-4 rows/cols, or fused
+// spectrum+tiles+rows followed by the stockham cols. All of them transform the same four tiles
+// per band, two real fields packed into each (spectrum.glsl)
+enum class FftPath
+{
+    Radix2,
+    Stockham,
+    Fused
+};
+static FftPath gFftPath = FftPath::Fused;
+
+// spectrum / fft resolution, power of two; baked into the shaders through specialization constants
+static int gFreqSize = 256;
+
+// displacement map storage: rgba32f, or rgba16f (halves what every consumer fetches); the FFT
+// chain itself stays fp32
+static bool gFftHalf = false;
+// pack the displacement map a second time at fp32 and report the max error per band
+static bool gFftValidate = false;
+
+// run the simulation (spectrum, FFT, packing, foam) on a dedicated compute queue, overlapped
+// with the previous frame's graphics work
+static bool gAsyncCompute = false;
+
+// simulate at a fixed rate in wave time (Hz) into a ring of displacement maps and blend the two
+// nearest simulated times; 0 = every frame
+static float gSimRate = 0.0f;
+
+// give each band its own update interval from the speed of its waves, so slow swell is transformed
+// only every few simulation steps (staggered between bands) and blended in between
+static bool gBandRates = false;
+
+// pick and cull the water tiles on the CPU into a mapped per-frame instance ring, instead of the
+// GPU cull pass and indirect draw
+static bool gCpuTiles = false;
+
+// water LOD: screen size (pixels) of a finest grid cell where it starts morphing into the next
+// level, every level doubling both; lower = denser
+static float gLodPixels = 2.0f;
+
+// water as a screen grid unprojected onto the sea plane every frame, instead of the CDLOD tiles
+// (O toggles, to compare the two on the same scene)
+static bool gProjectedGrid = false;
+
+// tessellate the water nodes on the GPU by screen size and crest steepness (falls back to the
+// plain vertex path without tessellation shaders)
+static bool gTessellation = false;
+
+// no water vertex buffers: water.vert rebuilds the grid vertex from gl_VertexIndex, only the
+// shared index buffers stay in memory
+static bool gVertexless = false;
+
+// lay down the depth of the water and the duck first, without fragment shaders, then shade them
+// with an EQUAL depth test: every covered pixel runs water.frag / boat.frag once
+static bool gDepthPrepass = false;
+
+// gpu timings
+static bool gProfilePrint = false;
+static std::string gProfileCsvPath;
+
+// water grid vertex: column and row of the grid, bit 15 of the row set on skirt vertices.
+// water.vert rebuilds the position from the grid size (R16G16_UINT, 4 bytes)
 struct MeshVert
 {
-    float xz[2];
-    float uv[2];
-    float skirt;
+    uint16_t grid[2];
 };
+static constexpr uint16_t kMeshVertSkirt = 0x8000;
+
+// reorders an index list for the post-transform vertex cache and prints the simulated gain
+static void optimizeMeshIndices(const std::string &name, std::vector<uint32_t> &indices, uint32_t vertexCount)
+{
+    VertexCacheStats before = measureVertexCache(indices, vertexCount);
+    optimizeVertexCache(indices, vertexCount);
+    VertexCacheStats after = measureVertexCache(indices, vertexCount);
+    std::cout << "Vertex cache (" << kVertexCacheSize << " FIFO) " << name
+              << ": ACMR " << before.acmr << " -> " << after.acmr
+              << "  ATVR " << before.atvr << " -> " << after.atvr << "\n";
+}
 
 static void printWaveParams()
 {
@@ -96,6 +188,9 @@ static void printWaveParams()
               << "  exposure=" << gExposure
               << "  waveSpeed=" << gWaveSpeed
               << "  bloom=" << gBloomStrength
+              << "  windAngle=" << glm::degrees(gWindAngle)
+              << "  windSpeed=" << gWindSpeedScale
+              << "  spectrumAmp=" << gSpectrumAmpScale
               << "\n";
 }
 
@@ -181,6 +276,31 @@ static void processInput(GLFWwindow *window, float dt)
     else
         pPressed = false;
 
+    static bool oPressed = false;
+    if (glfwGetKey(window, GLFW_KEY_O) == GLFW_PRESS)
+    {
+        if (!oPressed)
+        {
+            gProjectedGrid = !gProjectedGrid;
+            std::cout << "water: " << (gProjectedGrid ? "projected grid" : "CDLOD tiles") << "\n";
+            oPressed = true;
+        }
+    }
+    else
+        oPressed = false;
+
+    static bool tPressed = false;
+    if (glfwGetKey(window, GLFW_KEY_T) == GLFW_PRESS)
+    {
+        if (!tPressed)
+        {
+            gProfilePrint = !gProfilePrint;
+            tPressed = true;
+        }
+    }
+    else
+        tPressed = false;
+
     static bool d0 = false, d1 = false, d2 = false;
     if (glfwGetKey(window, GLFW_KEY_0) == GLFW_PRESS)
     {
@@ -273,6 +393,44 @@ static void processInput(GLFWwindow *window, float dt)
             gWaveSpeed = std::min(5.00f, gWaveSpeed + 0.05f);
             changed = true;
         }
+
+        if (glfwGetKey(window, GLFW_KEY_Z) == GLFW_PRESS)
+        {
+            gWindAngle -= 0.02f;
+            gSpectrumDirty = true;
+            changed = true;
+        }
+        if (glfwGetKey(window, GLFW_KEY_X) == GLFW_PRESS)
+        {
+            gWindAngle += 0.02f;
+            gSpectrumDirty = true;
+            changed = true;
+        }
+        if (glfwGetKey(window, GLFW_KEY_C) == GLFW_PRESS)
+        {
+            gWindSpeedScale = std::max(0.25f, gWindSpeedScale - 0.02f);
+            gSpectrumDirty = true;
+            changed = true;
+        }
+        if (glfwGetKey(window, GLFW_KEY_V) == GLFW_PRESS)
+        {
+            gWindSpeedScale = std::min(3.0f, gWindSpeedScale + 0.02f);
+            gSpectrumDirty = true;
+            changed = true;
+        }
+        if (glfwGetKey(window, GLFW_KEY_F) == GLFW_PRESS)
+        {
+            gSpectrumAmpScale = std::max(0.0f, gSpectrumAmpScale - 0.02f);
+            gSpectrumDirty = true;
+            changed = true;
+        }
+        if (glfwGetKey(window, GLFW_KEY_G) == GLFW_PRESS)
+        {
+            gSpectrumAmpScale = std::min(5.0f, gSpectrumAmpScale + 0.02f);
+            gSpectrumDirty = true;
+            changed = true;
+        }
+
         if (glfwGetKey(window, GLFW_KEY_I) == GLFW_PRESS)
         {
             gExposure = std::min(2.0f, gExposure + 0.03f);
@@ -354,9 +512,132 @@ static void processInput(GLFWwindow *window, float dt)
     }
 }
 
-static constexpr int FREQ_SIZE = 256;
 static constexpr float PATCH_SIZE = 512.0f;
 
+// CDLOD water: every PATCH_SIZE tile is the root of a quadtree kWaterLevels deep and every node, of
+// any size, is drawn with the same kWaterNodeGrid^2 mesh. Level 0 is the finest, level l covers
+// distances up to range0 * 2^l and morphs into the grid of level l + 1 from kWaterMorphStart of it.
+// Nothing is coarser than a tile: far tiles draw one node each, so their cost grows with the radius
+static constexpr int kWaterLevels = 4;
+static constexpr int kWaterNodeGrid = 32;
+static constexpr uint32_t kWaterNodesPerTile = ((1u << (2 * kWaterLevels)) - 1) / 3; // 64 + 16 + 4 + 1
+static constexpr float kWaterMorphStart = 0.7f;
+// skirts hang this far below the outer edge of the ocean (water.vert), and deepen the cull box of
+// the nodes along it (water_cull.comp, --cpu-tiles)
+static constexpr float kWaterSkirtDepth = 250.0f;
+
+// the selection rules of water_cull.comp, for the walk of --cpu-tiles. Level l is drawn out to
+// range0 * 2^l, and a node of level l + 1 nearer than that is split
+static float waterLevelRange(float range0, int level)
+{
+    return range0 * float(1 << level);
+}
+
+// where a node of level l has fully morphed into the grid of level l + 1, 0 = the coarsest level
+static float waterMorphEnd(float range0, int level)
+{
+    return level < kWaterLevels - 1 ? waterLevelRange(range0, level) : 0.0f;
+}
+
+// tiles outside the (radius + 0.5) circle around worldOrigin are not drawn; skirts hang where they border one
+static bool waterOutsideOcean(glm::ivec2 tile, int radius)
+{
+    const float rr = float(radius) + 0.5f;
+    return float(tile.x * tile.x + tile.y * tile.y) > rr * rr;
+}
+// projected grid: cells per side of the screen grid, the same vertex count at any radius
+static constexpr int kProjectedGrid = 384;
+// tessellated water: the node grid is laid out this many times coarser on screen, water.tesc
+// subdivides it back where it is near or steep
+static constexpr float kTessBaseScale = 4.0f;
+
+// Spectral bands (cascades). Each band is one array layer of the FFT images with its own patch
+// size, wind and amplitude, all batched into the same dispatches (gl_WorkGroupID.z = band), and
+// the surface is their weighted sum, so it only repeats at the least common multiple of the
+// patches. Cascades of one sea state split it by |k| so each wave number lives in one band.
+struct OceanBand
+{
+    float patchSize;
+    glm::vec2 wind;     // before gWindAngle
+    float amp;
+    float windSpeed;
+    uint32_t seed;
+    float kMin, kMax;   // |k| kept, kMax = 0 for no upper bound
+    float dispWeight;   // height / displacement
+    float normalWeight; // extra, normal only, faded out with distance
+    float fadeDist;     // displacement fades out by this distance, 0 = never
+};
+
+static constexpr float kTwoPi = 6.28318530718f;
+// a cascade takes over from the next larger one four of its wavelengths per patch in
+static constexpr float kSplitLong = kTwoPi / PATCH_SIZE * 4.0f;
+static constexpr float kSplitShort = kTwoPi / 131.0f * 4.0f;
+
+// bands on PATCH_SIZE also drive foam
+// and spray. patch sizes are deliberately not integer multiples of each other
+static const OceanBand kOceanBands[] = {
+    {PATCH_SIZE, {0.8f, 0.2f}, 0.0018f, 38.0f, 1337u, kSplitLong, kSplitShort, 1.0f, 0.0f, 0.0f},   // swell
+    {PATCH_SIZE, {1.0f, 0.0f}, 0.0030f, 22.0f, 424242u, 0.0f, 0.0f, 0.35f, 0.9f, 0.0f},             // wind
+    {2053.0f, {0.8f, 0.2f}, 0.0018f, 38.0f, 7331u, 0.0f, kSplitLong, 1.0f, 0.0f, 0.0f},             // long swell
+    {131.0f, {0.8f, 0.2f}, 0.0018f, 38.0f, 9001u, kSplitShort, 0.0f, 1.0f, 0.0f, 1400.0f},          // short swell
+};
+static constexpr uint32_t kMaxBands = 4; // MAX_BANDS in the shaders, one vec4 lane per band
+static constexpr uint32_t kBandCount = uint32_t(sizeof(kOceanBands) / sizeof(kOceanBands[0]));
+static_assert(kBandCount >= 1 && kBandCount <= kMaxBands, "1..kMaxBands spectral bands");
+// --band-rates: the slowest bands update every kMaxBandInterval simulation steps
+static constexpr uint32_t kMaxBandInterval = 4;
+
+// the FFT chain scales by kFftFinalScale / 256^2 overall at any N: the rows and cols take 1/N each
+// and the cols' final scale makes up the rest, so heights don't depend on the resolution
+static constexpr float kFftFinalScale = 25.0f;
+
+// the water cull bounds the summed bands by this many standard deviations of their height: a
+// Gaussian surface passes 5 sigma at about one point in 1.7 million
+static constexpr float kWaveSigmas = 5.0f;
+
+// Standard deviation of the height of the summed, displacement weighted bands, per unit of
+// heightScale, from the expected power of the spectrum spectrum_init.comp builds (the Phillips
+// terms of spectrum.glsl, 2 P(k) norm^2 per mode) and the scale of the FFT chain. The horizontal
+// displacements stay below it, their spectra are the height's times |kx| / |k| and |kz| / |k|.
+// Modes past 64 per axis are left out: their 1 / k^4 tail is well under a percent
+static float spectrumSigma(float windAngle, float ampScale, float windScale)
+{
+    const float g = 9.81f;
+    const float ca = std::cos(windAngle);
+    const float sa = std::sin(windAngle);
+    const int half = std::min(gFreqSize / 2, 64);
+    const double fftScale = double(kFftFinalScale) / (256.0 * 256.0);
+
+    double variance = 0.0;
+    for (const OceanBand &band : kOceanBands)
+    {
+        glm::vec2 wdir = glm::normalize(glm::vec2(ca * band.wind.x - sa * band.wind.y, sa * band.wind.x + ca * band.wind.y));
+        const double L = double(band.windSpeed * windScale) * double(band.windSpeed * windScale) / g;
+        const double amp = double(band.amp * ampScale);
+        const double norm = 512.0 / double(band.patchSize); // PATCH_REF in spectrum.glsl
+
+        double power = 0.0;
+        for (int iy = -half + 1; iy < half; ++iy) // the Nyquist row / column are dropped
+        {
+            for (int ix = -half + 1; ix < half; ++ix)
+            {
+                double kx = kTwoPi * ix / band.patchSize;
+                double ky = kTwoPi * iy / band.patchSize;
+                double k2 = kx * kx + ky * ky;
+                double k = std::sqrt(k2);
+                if (k < 1e-6 || k < band.kMin || (band.kMax > 0.0f && k >= band.kMax))
+                    continue;
+                double kw = (kx * wdir.x + ky * wdir.y) / k;
+                double damping = (L * 0.001) * (L * 0.001);
+                power += amp * std::exp(-1.0 / (k2 * L * L)) / (k2 * k2) * kw * kw * std::exp(-k2 * damping) *
+                         std::exp(-k2 * 0.0005);
+            }
+        }
+        variance += double(band.dispWeight) * band.dispWeight * fftScale * fftScale * 2.0 * power * norm * norm;
+    }
+    return (float)std::sqrt(variance);
+}
+
 static constexpr uint32_t MAX_PARTICLES = 16384;
 
 struct alignas(16) GlobalUBO
@@ -371,6 +652,11 @@ struct alignas(16) GlobalUBO
     glm::vec4 screen;
     glm::vec4 boat0;
     glm::vec4 boat1;
+    glm::vec4 bandPatch; // 0 = no band
+    glm::vec4 bandDisp;
+    glm::vec4 bandNormal;
+    glm::vec4 bandFade;
+    glm::mat4 bandRing; // column per band: layer of its older / newer simulated state, weight of the newer
 };
 
 struct alignas(16) TaaUBO
@@ -383,7 +669,8 @@ struct alignas(16) TaaUBO
 struct alignas(16) WaterPush
 {
     glm::vec2 worldOffset;
-    glm::vec2 _pad;
+    uint32_t nodeBase;   // first entry of this frame in the visible node buffer
+    int32_t oceanRadius; // tiles around worldOrigin (0 = the single tile), for the outer skirts
 };
 
 struct alignas(16) BoatPush
@@ -405,27 +692,60 @@ static VkPipeline createGraphicsPipeline(
     VkPolygonMode polyMode,
     VkCullModeFlags cullMode,
     bool depthTest = true,
-    bool enableBlend = false)
+    bool enableBlend = false,
+    const VkSpecializationInfo *spec = nullptr,
+    const std::string &tescPath = {},
+    const std::string &tesePath = {})
 {
+    // no fragment shader: depth only, color writes masked (the --depth-prepass pipelines)
+    const bool depthOnly = fsPath.empty();
     auto vsCode = readFileBinary(vsPath);
-    auto fsCode = readFileBinary(fsPath);
     VkShaderModule vs = createShaderModule(device, vsCode);
-    VkShaderModule fs = createShaderModule(device, fsCode);
+    VkShaderModule fs{};
+    if (!depthOnly)
+        fs = createShaderModule(device, readFileBinary(fsPath));
+
+    // with both tessellation stages the input is a list of 3 point (triangle) patches
+    const bool tessellated = !tescPath.empty() && !tesePath.empty();
+    VkShaderModule tcs{}, tes{};
+    if (tessellated)
+    {
+        tcs = createShaderModule(device, readFileBinary(tescPath));
+        tes = createShaderModule(device, readFileBinary(tesePath));
+    }
 
-    VkPipelineShaderStageCreateInfo stages[2]{};
+    VkPipelineShaderStageCreateInfo stages[4]{};
     stages[0].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
     stages[0].stage = VK_SHADER_STAGE_VERTEX_BIT;
     stages[0].module = vs;
     stages[0].pName = "main";
+    stages[0].pSpecializationInfo = spec;
 
-    stages[1].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
-    stages[1].stage = VK_SHADER_STAGE_FRAGMENT_BIT;
-    stages[1].module = fs;
-    stages[1].pName = "main";
+    uint32_t stageCount = 1;
+    if (!depthOnly)
+    {
+        stages[1].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+        stages[1].stage = VK_SHADER_STAGE_FRAGMENT_BIT;
+        stages[1].module = fs;
+        stages[1].pName = "main";
+        stages[1].pSpecializationInfo = spec;
+        stageCount++;
+    }
+
+    if (tessellated)
+    {
+        stages[stageCount] = stages[0];
+        stages[stageCount].stage = VK_SHADER_STAGE_TESSELLATION_CONTROL_BIT;
+        stages[stageCount].module = tcs;
+        stages[stageCount + 1] = stages[0];
+        stages[stageCount + 1].stage = VK_SHADER_STAGE_TESSELLATION_EVALUATION_BIT;
+        stages[stageCount + 1].module = tes;
+        stageCount += 2;
+    }
 
     VkPipelineVertexInputStateCreateInfo vi{VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO};
     VkVertexInputBindingDescription bind{};
-    std::array<VkVertexInputAttributeDescription, 3> attrs{};
+    std::array<VkVertexInputAttributeDescription, 1> attrs{};
     if (enableVertexInput)
     {
         bind.binding = 0;
@@ -434,18 +754,8 @@ static VkPipeline createGraphicsPipeline(
 
         attrs[0].location = 0;
         attrs[0].binding = 0;
-        attrs[0].format = VK_FORMAT_R32G32_SFLOAT;
-        attrs[0].offset = offsetof(MeshVert, xz);
-
-        attrs[1].location = 1;
-        attrs[1].binding = 0;
-        attrs[1].format = VK_FORMAT_R32G32_SFLOAT;
-        attrs[1].offset = offsetof(MeshVert, uv);
-
-        attrs[2].location = 2;
-        attrs[2].binding = 0;
-        attrs[2].format = VK_FORMAT_R32_SFLOAT;
-        attrs[2].offset = offsetof(MeshVert, skirt);
+        attrs[0].format = VK_FORMAT_R16G16_UINT;
+        attrs[0].offset = offsetof(MeshVert, grid);
 
         vi.vertexBindingDescriptionCount = 1;
         vi.pVertexBindingDescriptions = &bind;
@@ -454,9 +764,12 @@ static VkPipeline createGraphicsPipeline(
     }
 
     VkPipelineInputAssemblyStateCreateInfo ia{VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO};
-    ia.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+    ia.topology = tessellated ? VK_PRIMITIVE_TOPOLOGY_PATCH_LIST : VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
     ia.primitiveRestartEnable = VK_FALSE;
 
+    VkPipelineTessellationStateCreateInfo ts{VK_STRUCTURE_TYPE_PIPELINE_TESSELLATION_STATE_CREATE_INFO};
+    ts.patchControlPoints = 3;
+
     VkPipelineViewportStateCreateInfo vp{VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO};
     vp.viewportCount = 1;
     vp.scissorCount = 1;
@@ -481,7 +794,8 @@ static VkPipeline createGraphicsPipeline(
     ds.stencilTestEnable = VK_FALSE;
 
     VkPipelineColorBlendAttachmentState cbAtt{};
-    cbAtt.colorWriteMask = VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT;
+    if (!depthOnly)
+        cbAtt.colorWriteMask = VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT;
     cbAtt.blendEnable = enableBlend ? VK_TRUE : VK_FALSE;
     if (enableBlend)
     {
@@ -504,10 +818,11 @@ static VkPipeline createGraphicsPipeline(
     dyn.pDynamicStates = dynStates.data();
 
     VkGraphicsPipelineCreateInfo gp{VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO};
-    gp.stageCount = 2;
+    gp.stageCount = stageCount;
     gp.pStages = stages;
     gp.pVertexInputState = &vi;
     gp.pInputAssemblyState = &ia;
+    gp.pTessellationState = tessellated ? &ts : nullptr;
     gp.pViewportState = &vp;
     gp.pRasterizationState = &rs;
     gp.pMultisampleState = &ms;
@@ -523,7 +838,13 @@ static VkPipeline createGraphicsPipeline(
         throw std::runtime_error("vkCreateGraphicsPipelines failed");
 
     vkDestroyShaderModule(device, vs, nullptr);
-    vkDestroyShaderModule(device, fs, nullptr);
+    if (fs)
+        vkDestroyShaderModule(device, fs, nullptr);
+    if (tessellated)
+    {
+        vkDestroyShaderModule(device, tcs, nullptr);
+        vkDestroyShaderModule(device, tes, nullptr);
+    }
     return pipeline;
 }
 
@@ -539,23 +860,29 @@ static VkPipeline createGraphicsPipelineObjMesh(
     VkPolygonMode polyMode,
     VkCullModeFlags cullMode,
     bool depthTest = true,
-    bool enableBlend = false)
+    bool enableBlend = false,
+    const VkSpecializationInfo *spec = nullptr)
 {
+    // no fragment shader: depth only, as in createGraphicsPipeline
+    const bool depthOnly = fsPath.empty();
     auto vsCode = readFileBinary(vsPath);
-    auto fsCode = readFileBinary(fsPath);
     VkShaderModule vs = createShaderModule(device, vsCode);
-    VkShaderModule fs = createShaderModule(device, fsCode);
+    VkShaderModule fs{};
+    if (!depthOnly)
+        fs = createShaderModule(device, readFileBinary(fsPath));
 
     VkPipelineShaderStageCreateInfo stages[2]{};
     stages[0].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
     stages[0].stage = VK_SHADER_STAGE_VERTEX_BIT;
     stages[0].module = vs;
     stages[0].pName = "main";
+    stages[0].pSpecializationInfo = spec;
 
     stages[1].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
     stages[1].stage = VK_SHADER_STAGE_FRAGMENT_BIT;
     stages[1].module = fs;
     stages[1].pName = "main";
+    stages[1].pSpecializationInfo = spec;
 
     VkVertexInputBindingDescription bind{};
     bind.binding = 0;
@@ -624,7 +951,8 @@ static VkPipeline createGraphicsPipelineObjMesh(
     ds.stencilTestEnable = VK_FALSE;
 
     VkPipelineColorBlendAttachmentState cbAtt{};
-    cbAtt.colorWriteMask = VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT;
+    if (!depthOnly)
+        cbAtt.colorWriteMask = VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT;
     cbAtt.blendEnable = enableBlend ? VK_TRUE : VK_FALSE;
     if (enableBlend)
     {
@@ -646,7 +974,7 @@ static VkPipeline createGraphicsPipelineObjMesh(
     dyn.pDynamicStates = dynStates;
 
     VkGraphicsPipelineCreateInfo ci{VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO};
-    ci.stageCount = 2;
+    ci.stageCount = depthOnly ? 1 : 2;
     ci.pStages = stages;
     ci.pVertexInputState = &vi;
     ci.pInputAssemblyState = &ia;
@@ -665,14 +993,16 @@ static VkPipeline createGraphicsPipelineObjMesh(
         throw std::runtime_error("vkCreateGraphicsPipelines(ducky obj file) failed");
 
     vkDestroyShaderModule(device, vs, nullptr);
-    vkDestroyShaderModule(device, fs, nullptr);
+    if (fs)
+        vkDestroyShaderModule(device, fs, nullptr);
     return pipeline;
 }
 
 static VkPipeline createComputePipeline(
     VkDevice device,
     VkPipelineLayout layout,
-    const std::string &csPath)
+    const std::string &csPath,
+    const VkSpecializationInfo *spec = nullptr)
 {
     auto code = readFileBinary(csPath);
     VkShaderModule cs = createShaderModule(device, code);
@@ -681,8 +1011,11 @@ static VkPipeline createComputePipeline(
     stage.stage = VK_SHADER_STAGE_COMPUTE_BIT;
     stage.module = cs;
     stage.pName = "main";
+    stage.pSpecializationInfo = spec;
 
     VkComputePipelineCreateInfo ci{VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO};
+    // the band passes dispatch a subset of the bands with a base workgroup z (vkCmdDispatchBase)
+    ci.flags = VK_PIPELINE_CREATE_DISPATCH_BASE_BIT;
     ci.stage = stage;
     ci.layout = layout;
 
@@ -740,6 +1073,150 @@ static void bufferBarrier(
     vkCmdPipelineBarrier(cmd, srcStage, dstStage, 0, 0, nullptr, 1, &b, 0, nullptr);
 }
 
+static void printUsage(const char *exe)
+{
+    std::cout << "usage: " << exe << " [options]\n"
+              << "  --headless        render offscreen, no window or swapchain\n"
+              << "  --frames N        exit after N frames (headless default 300)\n"
+              << "  --fixed-dt S      advance the simulation by S seconds per frame (headless default 1/60)\n"
+              << "  --size WxH        render resolution (default 1920x1080)\n"
+              << "  --output F.ppm    headless: write the last frame to F.ppm\n"
+              << "  --fft KIND        fused (default: spectrum+rows, cols), stockham or radix2 FFT kernels\n"
+              << "  --fft-size N      spectrum resolution, power of two in 64..2048 (default 256)\n"
+              << "  --fft-precision P fp32 (default) or fp16 displacement storage\n"
+              << "  --fft-validate    compare the displacement against an fp32 rerun, print the max error every second\n"
+              << "  --async-compute   simulate on a separate compute queue, overlapped with rendering\n"
+              << "  --sim-rate HZ     simulate at a fixed rate of wave time and blend between steps (default 0 = every frame)\n"
+              << "  --band-rates      update slow bands (swell) less often than fast ones, staggered\n"
+              << "  --cpu-tiles       cull the water tiles on the CPU, one instanced draw (default: GPU, indirect)\n"
+              << "  --lod-px PX       screen size of the finest water cells before they morph coarser (default 2)\n"
+              << "  --projected-grid  start with the camera-projected water grid instead of the tiles (O toggles)\n"
+              << "  --tessellation    subdivide the water tiles on the GPU, denser near the camera and on crests\n"
+              << "  --vertexless      draw the water without vertex buffers, the grid vertex from the index\n"
+              << "  --depth-prepass   depth-only pass for the water and duck, then shade each pixel once (EQUAL)\n"
+              << "  --profile         print per-pass GPU timings and fragment shader invocations every second\n"
+              << "  --profile-csv F   write per-frame, per-pass GPU timings to F\n";
+}
+
+// returns false if the program should exit without running
+static bool parseArgs(int argc, char **argv)
+{
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string a = argv[i];
+        auto next = [&]() -> const char *
+        {
+            if (i + 1 >= argc)
+                throw std::runtime_error("missing value for " + a);
+            return argv[++i];
+        };
+
+        if (a == "--headless")
+            gHeadless = true;
+        else if (a == "--frames")
+            gMaxFrames = std::max(0, std::atoi(next()));
+        else if (a == "--fixed-dt")
+            gFixedDt = std::max(0.0f, (float)std::atof(next()));
+        else if (a == "--size")
+        {
+            unsigned w = 0, h = 0;
+            if (std::sscanf(next(), "%ux%u", &w, &h) != 2 || w == 0 || h == 0)
+                throw std::runtime_error("--size expects WxH");
+            gWidth = w;
+            gHeight = h;
+        }
+        else if (a == "--output")
+            gOutputPath = next();
+        else if (a == "--fft")
+        {
+            std::string k = next();
+            if (k == "fused")
+                gFftPath = FftPath::Fused;
+            else if (k == "stockham")
+                gFftPath = FftPath::Stockham;
+            else if (k == "radix2")
+                gFftPath = FftPath::Radix2;
+            else
+                throw std::runtime_error("--fft expects fused, stockham or radix2");
+        }
+        else if (a == "--fft-size")
+        {
+            int n = std::atoi(next());
+            if (n < 64 || n > 2048 || (n & (n - 1)) != 0)
+                throw std::runtime_error("--fft-size expects a power of two in 64..2048");
+            gFreqSize = n;
+        }
+        else if (a == "--fft-precision")
+        {
+            std::string p = next();
+            if (p == "fp32")
+                gFftHalf = false;
+            else if (p == "fp16")
+                gFftHalf = true;
+            else
+                throw std::runtime_error("--fft-precision expects fp32 or fp16");
+        }
+        else if (a == "--fft-validate")
+            gFftValidate = true;
+        else if (a == "--async-compute")
+            gAsyncCompute = true;
+        else if (a == "--sim-rate")
+        {
+            gSimRate = (float)std::atof(next());
+            if (gSimRate < 0.0f)
+                throw std::runtime_error("--sim-rate expects a rate in Hz, 0 = every frame");
+        }
+        else if (a == "--band-rates")
+            gBandRates = true;
+        else if (a == "--cpu-tiles")
+            gCpuTiles = true;
+        else if (a == "--projected-grid")
+            gProjectedGrid = true;
+        else if (a == "--tessellation")
+            gTessellation = true;
+        else if (a == "--vertexless")
+            gVertexless = true;
+        else if (a == "--depth-prepass")
+            gDepthPrepass = true;
+        else if (a == "--lod-px")
+        {
+            gLodPixels = (float)std::atof(next());
+            if (gLodPixels <= 0.0f)
+                throw std::runtime_error("--lod-px expects a size in pixels > 0");
+        }
+        else if (a == "--profile")
+            gProfilePrint = true;
+        else if (a == "--profile-csv")
+            gProfileCsvPath = next();
+        else if (a == "--help" || a == "-h")
+        {
+            printUsage(argv[0]);
+            return false;
+        }
+        else
+            throw std::runtime_error("unknown option " + a);
+    }
+
+    if (gHeadless)
+    {
+        if (gMaxFrames == 0)
+            gMaxFrames = 300;
+        if (gFixedDt == 0.0f)
+            gFixedDt = 1.0f / 60.0f;
+    }
+    return true;
+}
+
+static void writePPM(const std::string &path, uint32_t w, uint32_t h, const std::vector<uint8_t> &rgba)
+{
+    std::ofstream f(path, std::ios::binary);
+    if (!f)
+        throw std::runtime_error("cannot open " + path);
+    f << "P6\n" << w << " " << h << "\n255\n";
+    for (size_t i = 0; i < (size_t)w * h; ++i)
+        f.write((const char *)&rgba[i * 4], 3);
+}
+
 int main(int argc, char **argv)
 {
     fs::path exeDir = (argc > 0) ? fs::absolute(argv[0]).parent_path() : fs::current_path();
@@ -749,25 +1226,44 @@ int main(int argc, char **argv)
     std::cout << "SPV:    " << spvDir.string() << "\n";
     std::cout << "Assets: " << assetsDir.string() << "\n";
 
-    if (!glfwInit())
+    try
     {
-        std::cerr << "GLFW init failed\n";
-        return -1;
+        if (!parseArgs(argc, argv))
+            return 0;
     }
-
-    glfwWindowHint(GLFW_CLIENT_API, GLFW_NO_API);
-    GLFWwindow *window = glfwCreateWindow(1920, 1080, "Vulkan Ocean Render", nullptr, nullptr);
-    if (!window)
+    catch (const std::exception &e)
     {
-        std::cerr << "Window creation failed\n";
-        glfwTerminate();
+        std::cerr << e.what() << "\n";
+        printUsage(argv[0]);
         return -1;
     }
 
-    glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
-    glfwSetCursorPosCallback(window, mouse_callback);
+    GLFWwindow *window = nullptr;
+    if (!gHeadless)
+    {
+        if (!glfwInit())
+        {
+            std::cerr << "GLFW init failed\n";
+            return -1;
+        }
+
+        glfwWindowHint(GLFW_CLIENT_API, GLFW_NO_API);
+        window = glfwCreateWindow((int)gWidth, (int)gHeight, "Vulkan Ocean Render", nullptr, nullptr);
+        if (!window)
+        {
+            std::cerr << "Window creation failed\n";
+            glfwTerminate();
+            return -1;
+        }
+
+        glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
+        glfwSetCursorPosCallback(window, mouse_callback);
+    }
 
     VkContext ctx;
+    ctx.asyncCompute = gAsyncCompute;
+    ctx.tessellation = gTessellation;
+    ctx.pipelineStatistics = true; // fragment invocations in the --profile / T summary
     bool enableValidation = true;
 #ifndef NDEBUG
     enableValidation = true;
@@ -776,7 +1272,10 @@ int main(int argc, char **argv)
 #endif
     try
     {
-        ctx.init(window, enableValidation);
+        if (gHeadless)
+            ctx.initHeadless(gWidth, gHeight, enableValidation);
+        else
+            ctx.init(window, enableValidation);
     }
     catch (const std::exception &e)
     {
@@ -785,13 +1284,37 @@ int main(int argc, char **argv)
         return -1;
     }
 
+    // with async compute the simulation passes are timed on their own queue, into F.compute.csv
+    GpuProfiler profiler;
+    GpuProfiler computeProfiler;
+    try
+    {
+        profiler.init(ctx.phys, ctx.device, ctx.graphicsQFamily, VkContext::kMaxFrames, ctx.pipelineStatistics);
+        if (!gProfileCsvPath.empty())
+            profiler.openCsv(gProfileCsvPath);
+        if (ctx.asyncCompute)
+        {
+            computeProfiler.init(ctx.phys, ctx.device, ctx.computeQFamily, VkContext::kMaxFrames);
+            if (!gProfileCsvPath.empty())
+                computeProfiler.openCsv(gProfileCsvPath + ".compute.csv");
+        }
+    }
+    catch (const std::exception &e)
+    {
+        std::cerr << "Profiler init error: " << e.what() << "\n";
+    }
+
+    // the tessellated water reads Global and the band maps in its control / evaluation stages
+    const VkShaderStageFlags tessStages =
+        ctx.tessellation ? VK_SHADER_STAGE_TESSELLATION_CONTROL_BIT | VK_SHADER_STAGE_TESSELLATION_EVALUATION_BIT : 0;
+
     VkDescriptorSetLayout uboSetLayout{};
     {
         VkDescriptorSetLayoutBinding b{};
         b.binding = 0;
         b.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
         b.descriptorCount = 1;
-        b.stageFlags = VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT;
+        b.stageFlags = VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT | tessStages;
 
         VkDescriptorSetLayoutCreateInfo ci{VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO};
         ci.bindingCount = 1;
@@ -802,28 +1325,31 @@ int main(int argc, char **argv)
 
     VkDescriptorSetLayout texSetLayout{};
     {
-        // 0 FFT
+        // 0 FFT bands (array)
         // 1 HDR
         // 2 Foam
         // 3 SceneColor
         // 4 SceneDepth
-        // 5 FFT detail
+        // 5 FFT derivatives (array, slopes + Jacobian terms)
         // 6 Wake
+        // 7 visible water nodes (storage buffer, water_cull.comp)
 
-        std::array<VkDescriptorSetLayoutBinding, 7> b{};
+        std::array<VkDescriptorSetLayoutBinding, 8> b{};
         for (uint32_t i = 0; i < (uint32_t)b.size(); i++)
         {
             b[i].binding = i;
             b[i].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
             b[i].descriptorCount = 1;
         }
-        b[0].stageFlags = VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT;
+        b[0].stageFlags = VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT | tessStages;
         b[1].stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
         b[2].stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
         b[3].stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
         b[4].stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
-        b[5].stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+        b[5].stageFlags = VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT | tessStages;
         b[6].stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+        b[7].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        b[7].stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
 
         VkDescriptorSetLayoutCreateInfo ci{VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO};
         ci.bindingCount = (uint32_t)b.size();
@@ -832,16 +1358,20 @@ int main(int argc, char **argv)
             throw std::runtime_error("vkCreateDescriptorSetLayout failed");
     }
 
+    // output + cached h0 and w
     VkDescriptorSetLayout compSpectrumSetLayout{};
     {
-        VkDescriptorSetLayoutBinding b{};
-        b.binding = 0;
-        b.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
-        b.descriptorCount = 1;
-        b.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+        std::array<VkDescriptorSetLayoutBinding, 3> b{};
+        for (uint32_t i = 0; i < 3; i++)
+        {
+            b[i].binding = i;
+            b[i].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+            b[i].descriptorCount = 1;
+            b[i].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+        }
         VkDescriptorSetLayoutCreateInfo ci{VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO};
-        ci.bindingCount = 1;
-        ci.pBindings = &b;
+        ci.bindingCount = (uint32_t)b.size();
+        ci.pBindings = b.data();
         if (vkCreateDescriptorSetLayout(ctx.device, &ci, nullptr, &compSpectrumSetLayout) != VK_SUCCESS)
             throw std::runtime_error("vkCreateDescriptorSetLayout(compSpectrum) failed");
     }
@@ -863,7 +1393,8 @@ int main(int argc, char **argv)
             throw std::runtime_error("vkCreateDescriptorSetLayout(comp2img) failed");
     }
 
-    VkDescriptorSetLayout comp3ImgSetLayout{};
+    // cols output in, displacement + derivative maps out
+    VkDescriptorSetLayout compDispPackSetLayout{};
     {
         std::array<VkDescriptorSetLayoutBinding, 3> b{};
         for (uint32_t i = 0; i < 3; i++)
@@ -876,14 +1407,29 @@ int main(int argc, char **argv)
         VkDescriptorSetLayoutCreateInfo ci{VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO};
         ci.bindingCount = (uint32_t)b.size();
         ci.pBindings = b.data();
-        if (vkCreateDescriptorSetLayout(ctx.device, &ci, nullptr, &comp3ImgSetLayout) != VK_SUCCESS)
-            throw std::runtime_error("vkCreateDescriptorSetLayout(comp3img) failed");
+        if (vkCreateDescriptorSetLayout(ctx.device, &ci, nullptr, &compDispPackSetLayout) != VK_SUCCESS)
+            throw std::runtime_error("vkCreateDescriptorSetLayout(compDispPack) failed");
+    }
+
+    // stockham fft twiddle table
+    VkDescriptorSetLayout twiddleSetLayout{};
+    {
+        VkDescriptorSetLayoutBinding b{};
+        b.binding = 0;
+        b.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        b.descriptorCount = 1;
+        b.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+        VkDescriptorSetLayoutCreateInfo ci{VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO};
+        ci.bindingCount = 1;
+        ci.pBindings = &b;
+        if (vkCreateDescriptorSetLayout(ctx.device, &ci, nullptr, &twiddleSetLayout) != VK_SUCCESS)
+            throw std::runtime_error("vkCreateDescriptorSetLayout(twiddle) failed");
     }
 
     // foam
     VkDescriptorSetLayout compFoamSetLayout{};
     {
-        std::array<VkDescriptorSetLayoutBinding, 3> b{};
+        std::array<VkDescriptorSetLayoutBinding, 4> b{};
         b[0].binding = 0;
         b[0].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
         b[0].descriptorCount = 1;
@@ -899,6 +1445,11 @@ int main(int argc, char **argv)
         b[2].descriptorCount = 1;
         b[2].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
 
+        b[3].binding = 3;
+        b[3].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+        b[3].descriptorCount = 1;
+        b[3].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+
         VkDescriptorSetLayoutCreateInfo ci{VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO};
         ci.bindingCount = (uint32_t)b.size();
         ci.pBindings = b.data();
@@ -906,10 +1457,36 @@ int main(int argc, char **argv)
             throw std::runtime_error("vkCreateDescriptorSetLayout(compFoam) failed");
     }
 
+    // fft validation: displacement + fp32 reference, max error buffer
+    VkDescriptorSetLayout compValidateSetLayout{};
+    {
+        std::array<VkDescriptorSetLayoutBinding, 3> b{};
+        b[0].binding = 0;
+        b[0].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+        b[0].descriptorCount = 1;
+        b[0].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+
+        b[1].binding = 1;
+        b[1].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+        b[1].descriptorCount = 1;
+        b[1].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+
+        b[2].binding = 2;
+        b[2].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        b[2].descriptorCount = 1;
+        b[2].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+
+        VkDescriptorSetLayoutCreateInfo ci{VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO};
+        ci.bindingCount = (uint32_t)b.size();
+        ci.pBindings = b.data();
+        if (vkCreateDescriptorSetLayout(ctx.device, &ci, nullptr, &compValidateSetLayout) != VK_SUCCESS)
+            throw std::runtime_error("vkCreateDescriptorSetLayout(compValidate) failed");
+    }
+
     // spray
     VkDescriptorSetLayout compSpraySetLayout{};
     {
-        std::array<VkDescriptorSetLayoutBinding, 3> b{};
+        std::array<VkDescriptorSetLayoutBinding, 4> b{};
         b[0].binding = 0;
         b[0].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
         b[0].descriptorCount = 1;
@@ -925,6 +1502,11 @@ int main(int argc, char **argv)
         b[2].descriptorCount = 1;
         b[2].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
 
+        b[3].binding = 3;
+        b[3].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+        b[3].descriptorCount = 1;
+        b[3].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+
         VkDescriptorSetLayoutCreateInfo ci{VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO};
         ci.bindingCount = (uint32_t)b.size();
         ci.pBindings = b.data();
@@ -946,6 +1528,24 @@ int main(int argc, char **argv)
             throw std::runtime_error("vkCreateDescriptorSetLayout(spray) failed");
     }
 
+    // water node selection and culling: indirect draw + visible nodes
+    VkDescriptorSetLayout compWaterCullSetLayout{};
+    {
+        std::array<VkDescriptorSetLayoutBinding, 2> b{};
+        for (uint32_t i = 0; i < (uint32_t)b.size(); i++)
+        {
+            b[i].binding = i;
+            b[i].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+            b[i].descriptorCount = 1;
+            b[i].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+        }
+        VkDescriptorSetLayoutCreateInfo ci{VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO};
+        ci.bindingCount = (uint32_t)b.size();
+        ci.pBindings = b.data();
+        if (vkCreateDescriptorSetLayout(ctx.device, &ci, nullptr, &compWaterCullSetLayout) != VK_SUCCESS)
+            throw std::runtime_error("vkCreateDescriptorSetLayout(compWaterCull) failed");
+    }
+
     VkDescriptorSetLayout taaSetLayout{};
     {
         std::array<VkDescriptorSetLayoutBinding, 4> b{};
@@ -1026,12 +1626,28 @@ int main(int argc, char **argv)
             throw std::runtime_error("vkCreatePipelineLayout(boat) failed");
     }
 
+    // h0 / w cache: two output images, parameters of every band
+    VkPipelineLayout compSpectrumInitLayout{};
+    {
+        VkPushConstantRange pc{};
+        pc.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+        pc.offset = 0;
+        pc.size = 128;
+        VkPipelineLayoutCreateInfo ci{VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO};
+        ci.setLayoutCount = 1;
+        ci.pSetLayouts = &comp2ImgSetLayout;
+        ci.pushConstantRangeCount = 1;
+        ci.pPushConstantRanges = &pc;
+        if (vkCreatePipelineLayout(ctx.device, &ci, nullptr, &compSpectrumInitLayout) != VK_SUCCESS)
+            throw std::runtime_error("vkCreatePipelineLayout(compSpectrumInit) failed");
+    }
+
     VkPipelineLayout compSpectrumLayout{};
     {
         VkPushConstantRange pc{};
         pc.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
         pc.offset = 0;
-        pc.size = 32;
+        pc.size = 16;
         VkPipelineLayoutCreateInfo ci{VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO};
         ci.setLayoutCount = 1;
         ci.pSetLayouts = &compSpectrumSetLayout;
@@ -1043,9 +1659,15 @@ int main(int argc, char **argv)
 
     VkPipelineLayout compBuildLayout{};
     {
+        VkPushConstantRange pc{};
+        pc.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+        pc.offset = 0;
+        pc.size = 16;
         VkPipelineLayoutCreateInfo ci{VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO};
         ci.setLayoutCount = 1;
         ci.pSetLayouts = &comp2ImgSetLayout;
+        ci.pushConstantRangeCount = 1;
+        ci.pPushConstantRanges = &pc;
         if (vkCreatePipelineLayout(ctx.device, &ci, nullptr, &compBuildLayout) != VK_SUCCESS)
             throw std::runtime_error("vkCreatePipelineLayout(compBuild) failed");
     }
@@ -1065,27 +1687,46 @@ int main(int argc, char **argv)
             throw std::runtime_error("vkCreatePipelineLayout(compIfft) failed");
     }
 
-    VkPipelineLayout compCombineLayout{};
+    // same as compIfft + set 1 twiddles
+    VkPipelineLayout compStockhamLayout{};
     {
         VkPushConstantRange pc{};
         pc.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
         pc.offset = 0;
         pc.size = 16;
+        VkDescriptorSetLayout setLayouts[2] = {comp2ImgSetLayout, twiddleSetLayout};
         VkPipelineLayoutCreateInfo ci{VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO};
-        ci.setLayoutCount = 1;
-        ci.pSetLayouts = &comp3ImgSetLayout;
+        ci.setLayoutCount = 2;
+        ci.pSetLayouts = setLayouts;
         ci.pushConstantRangeCount = 1;
         ci.pPushConstantRanges = &pc;
-        if (vkCreatePipelineLayout(ctx.device, &ci, nullptr, &compCombineLayout) != VK_SUCCESS)
-            throw std::runtime_error("vkCreatePipelineLayout(compCombine) failed");
+        if (vkCreatePipelineLayout(ctx.device, &ci, nullptr, &compStockhamLayout) != VK_SUCCESS)
+            throw std::runtime_error("vkCreatePipelineLayout(compStockham) failed");
     }
 
-    VkPipelineLayout compFoamLayout{};
+    // spectrum + tiles + rows, output and h0 / w cache + twiddles
+    VkPipelineLayout compFusedRowsLayout{};
     {
         VkPushConstantRange pc{};
         pc.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
         pc.offset = 0;
         pc.size = 48;
+        VkDescriptorSetLayout setLayouts[2] = {compSpectrumSetLayout, twiddleSetLayout};
+        VkPipelineLayoutCreateInfo ci{VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO};
+        ci.setLayoutCount = 2;
+        ci.pSetLayouts = setLayouts;
+        ci.pushConstantRangeCount = 1;
+        ci.pPushConstantRanges = &pc;
+        if (vkCreatePipelineLayout(ctx.device, &ci, nullptr, &compFusedRowsLayout) != VK_SUCCESS)
+            throw std::runtime_error("vkCreatePipelineLayout(compFusedRows) failed");
+    }
+
+    VkPipelineLayout compFoamLayout{};
+    {
+        VkPushConstantRange pc{};
+        pc.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+        pc.offset = 0;
+        pc.size = 80;
         VkPipelineLayoutCreateInfo ci{VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO};
         ci.setLayoutCount = 1;
         ci.pSetLayouts = &compFoamSetLayout;
@@ -1095,7 +1736,8 @@ int main(int argc, char **argv)
             throw std::runtime_error("vkCreatePipelineLayout(compFoam) failed");
     }
 
-    VkPipelineLayout compSprayUpdateLayout{};
+    // cols output (4N x N) -> displacement + derivative maps (N x N RGBA)
+    VkPipelineLayout compDispPackLayout{};
     {
         VkPushConstantRange pc{};
         pc.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
@@ -1103,19 +1745,65 @@ int main(int argc, char **argv)
         pc.size = 16;
         VkPipelineLayoutCreateInfo ci{VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO};
         ci.setLayoutCount = 1;
-        ci.pSetLayouts = &compSpraySetLayout;
+        ci.pSetLayouts = &compDispPackSetLayout;
         ci.pushConstantRangeCount = 1;
         ci.pPushConstantRanges = &pc;
-        if (vkCreatePipelineLayout(ctx.device, &ci, nullptr, &compSprayUpdateLayout) != VK_SUCCESS)
-            throw std::runtime_error("vkCreatePipelineLayout(compSprayUpdate) failed");
+        if (vkCreatePipelineLayout(ctx.device, &ci, nullptr, &compDispPackLayout) != VK_SUCCESS)
+            throw std::runtime_error("vkCreatePipelineLayout(compDispPack) failed");
     }
 
-    VkPipelineLayout compSpraySpawnLayout{};
+    // one mip of the displacement / derivative map from the level above
+    VkPipelineLayout compDispMipLayout{};
     {
         VkPushConstantRange pc{};
         pc.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
         pc.offset = 0;
-        pc.size = 64;
+        pc.size = 16;
+        VkPipelineLayoutCreateInfo ci{VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO};
+        ci.setLayoutCount = 1;
+        ci.pSetLayouts = &comp2ImgSetLayout;
+        ci.pushConstantRangeCount = 1;
+        ci.pPushConstantRanges = &pc;
+        if (vkCreatePipelineLayout(ctx.device, &ci, nullptr, &compDispMipLayout) != VK_SUCCESS)
+            throw std::runtime_error("vkCreatePipelineLayout(compDispMip) failed");
+    }
+
+    VkPipelineLayout compValidateLayout{};
+    {
+        VkPushConstantRange pc{};
+        pc.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+        pc.offset = 0;
+        pc.size = 32;
+        VkPipelineLayoutCreateInfo ci{VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO};
+        ci.setLayoutCount = 1;
+        ci.pSetLayouts = &compValidateSetLayout;
+        ci.pushConstantRangeCount = 1;
+        ci.pPushConstantRanges = &pc;
+        if (vkCreatePipelineLayout(ctx.device, &ci, nullptr, &compValidateLayout) != VK_SUCCESS)
+            throw std::runtime_error("vkCreatePipelineLayout(compValidate) failed");
+    }
+
+    VkPipelineLayout compSprayUpdateLayout{};
+    {
+        VkPushConstantRange pc{};
+        pc.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+        pc.offset = 0;
+        pc.size = 16;
+        VkPipelineLayoutCreateInfo ci{VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO};
+        ci.setLayoutCount = 1;
+        ci.pSetLayouts = &compSpraySetLayout;
+        ci.pushConstantRangeCount = 1;
+        ci.pPushConstantRanges = &pc;
+        if (vkCreatePipelineLayout(ctx.device, &ci, nullptr, &compSprayUpdateLayout) != VK_SUCCESS)
+            throw std::runtime_error("vkCreatePipelineLayout(compSprayUpdate) failed");
+    }
+
+    VkPipelineLayout compSpraySpawnLayout{};
+    {
+        VkPushConstantRange pc{};
+        pc.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+        pc.offset = 0;
+        pc.size = 96;
         VkPipelineLayoutCreateInfo ci{VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO};
         ci.setLayoutCount = 1;
         ci.pSetLayouts = &compSpraySetLayout;
@@ -1125,6 +1813,21 @@ int main(int argc, char **argv)
             throw std::runtime_error("vkCreatePipelineLayout(compSpraySpawn) failed");
     }
 
+    VkPipelineLayout compWaterCullLayout{};
+    {
+        VkPushConstantRange pc{};
+        pc.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+        pc.offset = 0;
+        pc.size = 128;
+        VkPipelineLayoutCreateInfo ci{VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO};
+        ci.setLayoutCount = 1;
+        ci.pSetLayouts = &compWaterCullSetLayout;
+        ci.pushConstantRangeCount = 1;
+        ci.pPushConstantRanges = &pc;
+        if (vkCreatePipelineLayout(ctx.device, &ci, nullptr, &compWaterCullLayout) != VK_SUCCESS)
+            throw std::runtime_error("vkCreatePipelineLayout(compWaterCull) failed");
+    }
+
     VkPipelineLayout sprayLayout{};
     {
         std::array<VkDescriptorSetLayout, 2> sets{uboSetLayout, spraySetLayout};
@@ -1162,34 +1865,194 @@ int main(int argc, char **argv)
     // graphics pipelines
     VkPipeline waterFill{};
     VkPipeline waterLine{};
+    VkPipeline waterProjFill{};
+    VkPipeline waterProjLine{};
     VkPipeline skyMainPipe{};
     VkPipeline boatPipe{};
+    // --depth-prepass: depth only water / duck, the three above then test EQUAL without writing
+    VkPipeline waterDepth{};
+    VkPipeline waterProjDepth{};
+    VkPipeline boatDepth{};
     VkPipeline sprayPipe{};
     VkPipeline taaPipe{};
     VkPipeline tonemapPipe{};
 
+    VkPipeline csSpectrumInit{};
     VkPipeline csSpectrum{};
     VkPipeline csBuild{};
     VkPipeline csRows{};
     VkPipeline csCols{};
-    VkPipeline csCombine{};
+    VkPipeline csStockhamRows{};
+    VkPipeline csStockhamCols{};
+    VkPipeline csFusedRows{};
+    VkPipeline csDispPack{};
+    VkPipeline csDispMip{};
+    VkPipeline csDispPackRef{}; // --fft-validate: the pack at fp32
+    VkPipeline csValidate{};
     VkPipeline csFoam{};
     VkPipeline csSprayUpdate{};
     VkPipeline csSpraySpawn{};
+    VkPipeline csWaterCull{};
 
     const auto spv = [&](const char *name)
     { return (spvDir / name).string(); };
+    // the pass that writes the displacement map has an rgba16f build, "<name>.fp16.spv"
+    const auto dispSpv = [&](const char *name, bool half)
+    { return (spvDir / (std::string(name) + (half ? ".fp16.spv" : ".spv"))).string(); };
+
+    // specialization constants shared by every shader that depends on the fft size:
+    // 0 = N, 1 = log2(N), 2 = fft workgroup width, 3 = fft axis (0 rows, 1 cols).
+    // shaders only declare the ids they use, the rest are ignored
+    struct FftSpecData
+    {
+        uint32_t n;
+        uint32_t logN;
+        uint32_t localX;
+        uint32_t axis;
+    };
+    const VkSpecializationMapEntry fftSpecEntries[4] = {
+        {0, offsetof(FftSpecData, n), sizeof(uint32_t)},
+        {1, offsetof(FftSpecData, logN), sizeof(uint32_t)},
+        {2, offsetof(FftSpecData, localX), sizeof(uint32_t)},
+        {3, offsetof(FftSpecData, axis), sizeof(uint32_t)},
+    };
+    const auto makeFftSpec = [&](const FftSpecData &d) -> VkSpecializationInfo
+    { return VkSpecializationInfo{4, fftSpecEntries, sizeof(FftSpecData), &d}; };
+
+    uint32_t fftLogN = 0;
+    while ((1 << fftLogN) < gFreqSize)
+        fftLogN++;
+
+    // radix-2 runs N/2 threads over one shared line, stockham N/4 threads ping-ponging two,
+    // fused four (rows) of those; fall back to a lighter path if the device can't fit N
+    {
+        VkPhysicalDeviceProperties props{};
+        vkGetPhysicalDeviceProperties(ctx.phys, &props);
+        const VkPhysicalDeviceLimits &lim = props.limits;
+        const uint32_t n = (uint32_t)gFreqSize;
+
+        auto fits = [&](FftPath path)
+        {
+            uint32_t threads = (path == FftPath::Radix2) ? n / 2 : n / 4;
+            uint32_t lines = (path == FftPath::Radix2) ? 1 : (path == FftPath::Stockham) ? 2 : 8;
+            uint32_t shared = lines * n * (uint32_t)sizeof(glm::vec2);
+            return threads <= lim.maxComputeWorkGroupInvocations &&
+                   threads <= lim.maxComputeWorkGroupSize[0] &&
+                   shared <= lim.maxComputeSharedMemorySize;
+        };
+
+        if (4 * n > lim.maxImageDimension2D)
+        {
+            std::cerr << "--fft-size " << n << " exceeds maxImageDimension2D\n";
+            ctx.cleanup();
+            glfwTerminate();
+            return -1;
+        }
+
+        const FftPath order[3] = {FftPath::Fused, FftPath::Stockham, FftPath::Radix2};
+        int start = 0;
+        while (order[start] != gFftPath)
+            start++;
+        int chosen = -1;
+        for (int i = start; i < 3 && chosen < 0; ++i)
+        {
+            if (fits(order[i]))
+                chosen = i;
+        }
+        if (chosen < 0)
+        {
+            std::cerr << "--fft-size " << n << " exceeds the compute limits of this device\n";
+            ctx.cleanup();
+            glfwTerminate();
+            return -1;
+        }
+        if (chosen != start)
+        {
+            static const char *names[3] = {"fused", "stockham", "radix2"};
+            std::cout << "FFT: " << names[start] << " kernels don't fit N=" << n << " on this device, using "
+                      << names[chosen] << "\n";
+            gFftPath = order[chosen];
+        }
+    }
+
+    // the displacement map is sampled with hardware bilinear, which is optional for rgba32f
+    // (and guaranteed for rgba16f)
+    if (!gFftHalf)
+    {
+        VkFormatProperties fp{};
+        vkGetPhysicalDeviceFormatProperties(ctx.phys, VK_FORMAT_R32G32B32A32_SFLOAT, &fp);
+        if (!(fp.optimalTilingFeatures & VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT))
+        {
+            std::cout << "FFT: no linear filtering of rgba32f on this device, using fp16\n";
+            gFftHalf = true;
+        }
+    }
+    const VkFormat dispFormat = gFftHalf ? VK_FORMAT_R16G16B16A16_SFLOAT : VK_FORMAT_R32G32B32A32_SFLOAT;
+
+    const uint32_t fftN = (uint32_t)gFreqSize;
+    // displacement map mips, N down to 8 x 8 (coarser is just the mean, which the fades handle)
+    const uint32_t dispMips = fftLogN - 2;
+    const FftSpecData sizeSpecData{fftN, fftLogN, 1, 0};
+    const VkSpecializationInfo sizeSpec = makeFftSpec(sizeSpecData);
 
     try
     {
-        csSpectrum = createComputePipeline(ctx.device, compSpectrumLayout, spv("spectrum.comp.spv"));
-        csBuild = createComputePipeline(ctx.device, compBuildLayout, spv("build_tiles.comp.spv"));
-        csRows = createComputePipeline(ctx.device, compIfftLayout, spv("ifft_rows.comp.spv"));
-        csCols = createComputePipeline(ctx.device, compIfftLayout, spv("ifft_cols.comp.spv"));
-        csCombine = createComputePipeline(ctx.device, compCombineLayout, spv("fft_combine.comp.spv"));
-        csFoam = createComputePipeline(ctx.device, compFoamLayout, spv("foam.comp.spv"));
+        csSpectrumInit = createComputePipeline(ctx.device, compSpectrumInitLayout, spv("spectrum_init.comp.spv"), &sizeSpec);
+        csSpectrum = createComputePipeline(ctx.device, compSpectrumLayout, spv("spectrum.comp.spv"), &sizeSpec);
+        csBuild = createComputePipeline(ctx.device, compBuildLayout, spv("build_tiles.comp.spv"), &sizeSpec);
+
+        if (gFftPath == FftPath::Radix2)
+        {
+            const FftSpecData d{fftN, fftLogN, fftN / 2, 0};
+            const VkSpecializationInfo spec = makeFftSpec(d);
+            csRows = createComputePipeline(ctx.device, compIfftLayout, spv("ifft_rows.comp.spv"), &spec);
+            csCols = createComputePipeline(ctx.device, compIfftLayout, spv("ifft_cols.comp.spv"), &spec);
+        }
+        else if (gFftPath == FftPath::Stockham)
+        {
+            const FftSpecData rows{fftN, fftLogN, fftN / 4, 0};
+            const FftSpecData cols{fftN, fftLogN, fftN / 4, 1};
+            const VkSpecializationInfo rowsSpec = makeFftSpec(rows);
+            const VkSpecializationInfo colsSpec = makeFftSpec(cols);
+            csStockhamRows = createComputePipeline(ctx.device, compStockhamLayout, spv("fft_stockham.comp.spv"), &rowsSpec);
+            csStockhamCols = createComputePipeline(ctx.device, compStockhamLayout, spv("fft_stockham.comp.spv"), &colsSpec);
+        }
+        else
+        {
+            const FftSpecData d{fftN, fftLogN, fftN / 4, 0};
+            const VkSpecializationInfo spec = makeFftSpec(d);
+            const FftSpecData cols{fftN, fftLogN, fftN / 4, 1};
+            const VkSpecializationInfo colsSpec = makeFftSpec(cols);
+            csFusedRows = createComputePipeline(ctx.device, compFusedRowsLayout, spv("fft_fused_rows.comp.spv"), &spec);
+            // the cols are a plain stockham pass, the bands are already in their own layers
+            csStockhamCols = createComputePipeline(ctx.device, compStockhamLayout, spv("fft_stockham.comp.spv"), &colsSpec);
+        }
+
+        csDispPack = createComputePipeline(ctx.device, compDispPackLayout, dispSpv("disp_pack.comp", gFftHalf), &sizeSpec);
+        csDispMip = createComputePipeline(ctx.device, compDispMipLayout, dispSpv("disp_mip.comp", gFftHalf));
+        if (gFftValidate)
+        {
+            // the reference only checks the displacement, DERIV (id 4) off leaves the derivative map alone
+            const uint32_t refSpecData[2] = {fftN, VK_FALSE};
+            const VkSpecializationMapEntry refSpecEntries[2] = {{0, 0, sizeof(uint32_t)},
+                                                                {4, sizeof(uint32_t), sizeof(VkBool32)}};
+            const VkSpecializationInfo refSpec{2, refSpecEntries, sizeof(refSpecData), refSpecData};
+            csDispPackRef = createComputePipeline(ctx.device, compDispPackLayout, dispSpv("disp_pack.comp", false), &refSpec);
+            csValidate = createComputePipeline(ctx.device, compValidateLayout, spv("fft_validate.comp.spv"), &sizeSpec);
+        }
+
+        csFoam = createComputePipeline(ctx.device, compFoamLayout, spv("foam.comp.spv"), &sizeSpec);
         csSprayUpdate = createComputePipeline(ctx.device, compSprayUpdateLayout, spv("spray_update.comp.spv"));
-        csSpraySpawn = createComputePipeline(ctx.device, compSpraySpawnLayout, spv("spray_spawn.comp.spv"));
+        csSpraySpawn = createComputePipeline(ctx.device, compSpraySpawnLayout, spv("spray_spawn.comp.spv"), &sizeSpec);
+        // the quadtree depth and skirt depth (constant_id 0, 1) from the same constants as the walk of --cpu-tiles
+        struct
+        {
+            int32_t levels = kWaterLevels;
+            float skirtDepth = kWaterSkirtDepth;
+        } cullSpecData;
+        const VkSpecializationMapEntry cullSpecEntries[2] = {{0, 0, sizeof(int32_t)}, {1, sizeof(int32_t), sizeof(float)}};
+        const VkSpecializationInfo cullSpec{2, cullSpecEntries, sizeof(cullSpecData), &cullSpecData};
+        csWaterCull = createComputePipeline(ctx.device, compWaterCullLayout, spv("water_cull.comp.spv"), &cullSpec);
     }
     catch (const std::exception &e)
     {
@@ -1203,7 +2066,7 @@ int main(int argc, char **argv)
     {
         // UBOs: GlobalUBO per frame + TAA UBO per frame
         // combined samplers: water/sky + scene refs + TAA + tonemap
-        // storage buffers: spray particles
+        // storage buffers: spray particles, visible water nodes
         std::array<VkDescriptorPoolSize, 3> sizes{};
         sizes[0] = {VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, VkContext::kMaxFrames * 2 + 8};
         sizes[1] = {VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 128};
@@ -1219,114 +2082,154 @@ int main(int argc, char **argv)
 
     VkDescriptorPool compPool{};
     {
-        // storage images: FFT chain + foam output
-        // combined samplers: foam reads FFT + foamPrev, spray spawn reads FFT
-        // storage buffers: spray particles + counter
+        // storage images: FFT chain + displacement / derivative mip chains + foam output
+        // combined samplers: foam reads FFT + derivatives + foamPrev, spray spawn reads FFT + derivatives,
+        // fft validation
+        // storage buffers: spray particles + counter, fft twiddles, fft validation, water node culling
         std::array<VkDescriptorPoolSize, 3> sizes{};
-        sizes[0] = {VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, 32};
+        sizes[0] = {VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, 96};
         sizes[1] = {VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 16};
         sizes[2] = {VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 8};
 
         VkDescriptorPoolCreateInfo ci{VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO};
-        ci.maxSets = 16;
+        ci.maxSets = 64;
         ci.poolSizeCount = (uint32_t)sizes.size();
         ci.pPoolSizes = sizes.data();
         if (vkCreateDescriptorPool(ctx.device, &ci, nullptr, &compPool) != VK_SUCCESS)
             throw std::runtime_error("vkCreateDescriptorPool(comp) failed");
     }
 
-    // 0 swell
-    AllocatedImage texH0 = createImage2D(
-        ctx.phys, ctx.device,
-        FREQ_SIZE, FREQ_SIZE,
-        1,
-        VK_FORMAT_R32G32_SFLOAT,
-        VK_IMAGE_USAGE_STORAGE_BIT,
-        VK_IMAGE_ASPECT_COLOR_BIT);
+    // async compute: everything the simulation touches is shared by both queue families
+    const std::vector<uint32_t> simFamilies = ctx.simQueueFamilies();
 
-    AllocatedImage texB0_0 = createImage2D(
-        ctx.phys, ctx.device,
-        3 * FREQ_SIZE, FREQ_SIZE,
-        1,
-        VK_FORMAT_R32G32_SFLOAT,
-        VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT,
-        VK_IMAGE_ASPECT_COLOR_BIT);
+    // simulation slots, kBandCount layers each of the displacement / derivative maps, so a band
+    // can be written while frames still in flight read its others: a ring of three with --sim-rate
+    // or --band-rates (the two simulated times being blended plus the one being written), two with
+    // async compute (this frame's and the previous frame's), else one
+    const uint32_t simSlots = (gSimRate > 0.0f || gBandRates) ? 3 : (ctx.asyncCompute ? 2 : 1);
+    const uint32_t dispLayers = simSlots * kBandCount;
 
-    AllocatedImage texB1_0 = createImage2D(
-        ctx.phys, ctx.device,
-        3 * FREQ_SIZE, FREQ_SIZE,
-        1,
-        VK_FORMAT_R32G32_SFLOAT,
-        VK_IMAGE_USAGE_STORAGE_BIT,
-        VK_IMAGE_ASPECT_COLOR_BIT);
+    // every FFT image holds one array layer per band; shaders index the layer, so even a single
+    // band gets an array view
+    const auto createBandImage = [&](uint32_t w, uint32_t layers, VkFormat format, VkImageUsageFlags usage,
+                                     uint32_t mips = 1)
+    {
+        AllocatedImage img = createImage2D(ctx.phys, ctx.device, w, fftN, mips, format, usage, VK_IMAGE_ASPECT_COLOR_BIT,
+                                           VK_SAMPLE_COUNT_1_BIT, VK_IMAGE_TILING_OPTIMAL, 0, layers, simFamilies);
+        if (layers == 1)
+        {
+            vkDestroyImageView(ctx.device, img.view, nullptr);
+            img.view = createImageView(ctx.device, img.image, format, VK_IMAGE_ASPECT_COLOR_BIT, mips,
+                                       VK_IMAGE_VIEW_TYPE_2D_ARRAY, 0, 0, 1);
+        }
+        return img;
+    };
 
-    // 1 wind
-    AllocatedImage texH1 = createImage2D(
-        ctx.phys, ctx.device,
-        FREQ_SIZE, FREQ_SIZE,
-        1,
-        VK_FORMAT_R32G32_SFLOAT,
-        VK_IMAGE_USAGE_STORAGE_BIT,
-        VK_IMAGE_ASPECT_COLOR_BIT);
+    // time independent spectrum: h0(k), conj(h0(-k)) and w(k), rebuilt when gSpectrumDirty
+    AllocatedImage texH0Cache = createBandImage(fftN, kBandCount, VK_FORMAT_R32G32B32A32_SFLOAT, VK_IMAGE_USAGE_STORAGE_BIT);
+    AllocatedImage texOmega = createBandImage(fftN, kBandCount, VK_FORMAT_R32_SFLOAT, VK_IMAGE_USAGE_STORAGE_BIT);
 
-    AllocatedImage texB0_1 = createImage2D(
-        ctx.phys, ctx.device,
-        3 * FREQ_SIZE, FREQ_SIZE,
-        1,
-        VK_FORMAT_R32G32_SFLOAT,
-        VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT,
-        VK_IMAGE_ASPECT_COLOR_BIT);
+    // H(k, t)
+    AllocatedImage texH = createBandImage(fftN, kBandCount, VK_FORMAT_R32G32_SFLOAT, VK_IMAGE_USAGE_STORAGE_BIT);
 
-    AllocatedImage texB1_1 = createImage2D(
-        ctx.phys, ctx.device,
-        3 * FREQ_SIZE, FREQ_SIZE,
-        1,
-        VK_FORMAT_R32G32_SFLOAT,
-        VK_IMAGE_USAGE_STORAGE_BIT,
-        VK_IMAGE_ASPECT_COLOR_BIT);
+    // 4N x N, the four packed field tiles per band (fieldTiles in spectrum.glsl): B0 = tiles in
+    // (radix-2 / stockham) and cols out, B1 = row pass out
+    AllocatedImage texB0 = createBandImage(4 * fftN, kBandCount, VK_FORMAT_R32G32_SFLOAT, VK_IMAGE_USAGE_STORAGE_BIT);
+    AllocatedImage texB1 = createBandImage(4 * fftN, kBandCount, VK_FORMAT_R32G32_SFLOAT, VK_IMAGE_USAGE_STORAGE_BIT);
 
-    // displacement field
-    AllocatedImage texBCombined = createImage2D(
-        ctx.phys, ctx.device,
-        3 * FREQ_SIZE, FREQ_SIZE,
-        1,
-        VK_FORMAT_R32G32_SFLOAT,
-        VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT,
-        VK_IMAGE_ASPECT_COLOR_BIT);
+    // displacement map, N x N (h, dx, dz, d dx / dz) per band, and the derivative map beside it
+    // (dh/dx, dh/dz, d dx / dx, d dz / dz); what the water, boat, foam and spray sample.
+    // Layer slot * kBandCount + band, every band moves through the slots on its own. The full
+    // view is sampled, storage goes through one view per mip
+    const auto createMipViews = [&](const AllocatedImage &img)
+    {
+        std::vector<VkImageView> views(dispMips);
+        for (uint32_t m = 0; m < dispMips; ++m)
+            views[m] = createImageView(ctx.device, img.image, dispFormat, VK_IMAGE_ASPECT_COLOR_BIT, 1,
+                                       VK_IMAGE_VIEW_TYPE_2D_ARRAY, m, 0, dispLayers);
+        return views;
+    };
+    AllocatedImage texDisp = createBandImage(fftN, dispLayers, dispFormat,
+                                             VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_SAMPLED_BIT, dispMips);
+    AllocatedImage texDeriv = createBandImage(fftN, dispLayers, dispFormat,
+                                              VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_SAMPLED_BIT, dispMips);
+    std::vector<VkImageView> dispMipViews = createMipViews(texDisp);
+    std::vector<VkImageView> derivMipViews = createMipViews(texDeriv);
+
+    // --fft-validate: the same map at fp32
+    AllocatedImage texDispRef{};
+    if (gFftValidate)
+        texDispRef = createBandImage(fftN, kBandCount, VK_FORMAT_R32G32B32A32_SFLOAT,
+                                     VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_SAMPLED_BIT);
+
+    // per frame slot: max |error| and max |reference| of each band as float bits, read back once
+    // the slot's fence has been waited on
+    AllocatedBuffer validateBuf{};
+    uint32_t *validateMap = nullptr;
+    if (gFftValidate)
+    {
+        const VkDeviceSize size = VkContext::kMaxFrames * 8 * sizeof(uint32_t);
+        validateBuf = createBuffer(ctx.phys, ctx.device, size, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+                                   VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+                                   simFamilies);
+        void *map = nullptr;
+        vkMapMemory(ctx.device, validateBuf.memory, 0, size, 0, &map);
+        validateMap = (uint32_t *)map;
+        std::memset(validateMap, 0, (size_t)size);
+    }
 
     {
         VkCommandBuffer cmd = beginSingleTimeCommands(ctx.device, ctx.cmdPool);
-        transitionImageLayout(cmd, texH0.image, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_GENERAL, VK_IMAGE_ASPECT_COLOR_BIT, 1);
-        transitionImageLayout(cmd, texB0_0.image, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_GENERAL, VK_IMAGE_ASPECT_COLOR_BIT, 1);
-        transitionImageLayout(cmd, texB1_0.image, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_GENERAL, VK_IMAGE_ASPECT_COLOR_BIT, 1);
-
-        transitionImageLayout(cmd, texH1.image, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_GENERAL, VK_IMAGE_ASPECT_COLOR_BIT, 1);
-        transitionImageLayout(cmd, texB0_1.image, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_GENERAL, VK_IMAGE_ASPECT_COLOR_BIT, 1);
-        transitionImageLayout(cmd, texB1_1.image, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_GENERAL, VK_IMAGE_ASPECT_COLOR_BIT, 1);
-
-        transitionImageLayout(cmd, texBCombined.image, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_GENERAL, VK_IMAGE_ASPECT_COLOR_BIT, 1);
+        for (AllocatedImage *img : {&texH0Cache, &texOmega, &texH, &texB0, &texB1, &texDisp, &texDeriv, &texDispRef})
+        {
+            if (img->image)
+                transitionImageLayout(cmd, img->image, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_GENERAL,
+                                      VK_IMAGE_ASPECT_COLOR_BIT, img->mipLevels, img->layers);
+        }
         endSingleTimeCommands(ctx.device, ctx.graphicsQ, ctx.cmdPool, cmd);
     }
 
-    VkSampler fftSampler = createSampler(ctx.device, VK_FILTER_LINEAR, VK_SAMPLER_ADDRESS_MODE_REPEAT, 0.0f, false, 1.0f);
+    // twiddles for the stockham kernels, tw[k] = e^{+2 pi i k / N}
+    AllocatedBuffer twiddleBuf = createBuffer(ctx.phys, ctx.device,
+                                              VkDeviceSize(gFreqSize) * sizeof(glm::vec2),
+                                              VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+                                              VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+                                              simFamilies);
+    {
+        std::vector<glm::vec2> tw(gFreqSize);
+        for (int k = 0; k < gFreqSize; ++k)
+        {
+            double a = 2.0 * 3.14159265358979323846 * double(k) / double(gFreqSize);
+            tw[k] = glm::vec2((float)std::cos(a), (float)std::sin(a));
+        }
+        void *map = nullptr;
+        vkMapMemory(ctx.device, twiddleBuf.memory, 0, twiddleBuf.size, 0, &map);
+        std::memcpy(map, tw.data(), (size_t)twiddleBuf.size);
+        vkUnmapMemory(ctx.device, twiddleBuf.memory);
+    }
+
+    // displacement map, trilinear over its mips (the shaders pick the lod)
+    VkSampler fftSampler = createSampler(ctx.device, VK_FILTER_LINEAR, VK_SAMPLER_ADDRESS_MODE_REPEAT, float(dispMips - 1), false, 1.0f);
 
     // foam ping pong
     AllocatedImage foamImg[2]{};
     foamImg[0] = createImage2D(
         ctx.phys, ctx.device,
-        FREQ_SIZE, FREQ_SIZE,
+        gFreqSize, gFreqSize,
         1,
         VK_FORMAT_R16_SFLOAT,
         VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT,
-        VK_IMAGE_ASPECT_COLOR_BIT);
+        VK_IMAGE_ASPECT_COLOR_BIT,
+        VK_SAMPLE_COUNT_1_BIT, VK_IMAGE_TILING_OPTIMAL, 0, 1, simFamilies);
 
     foamImg[1] = createImage2D(
         ctx.phys, ctx.device,
-        FREQ_SIZE, FREQ_SIZE,
+        gFreqSize, gFreqSize,
         1,
         VK_FORMAT_R16_SFLOAT,
         VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
-        VK_IMAGE_ASPECT_COLOR_BIT);
+        VK_IMAGE_ASPECT_COLOR_BIT,
+        VK_SAMPLE_COUNT_1_BIT, VK_IMAGE_TILING_OPTIMAL, 0, 1, simFamilies);
 
     // transition to GENERAL and clear to 0
     {
@@ -1364,6 +2267,31 @@ int main(int argc, char **argv)
                                                 VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
                                                 VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
 
+    // water quadtree nodes, selected and culled on the GPU every frame (water_cull.comp): one
+    // indexed indirect draw of the node mesh and the visible nodes, room for every node of the grid
+    const uint32_t waterNodeCapacity = uint32_t((2 * oceanRadius + 1) * (2 * oceanRadius + 1)) * kWaterNodesPerTile;
+    AllocatedBuffer waterDrawBuf = createBuffer(ctx.phys, ctx.device,
+                                                sizeof(VkDrawIndexedIndirectCommand),
+                                                VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT |
+                                                    VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+                                                VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+    AllocatedBuffer waterNodeBuf = createBuffer(ctx.phys, ctx.device,
+                                                VkDeviceSize(waterNodeCapacity) * sizeof(glm::vec4),
+                                                VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+                                                VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+
+    // --cpu-tiles: the same nodes written by the CPU, one range per frame slot, mapped for the run
+    AllocatedBuffer waterNodeRing{};
+    glm::vec4 *waterNodeRingMap = nullptr;
+    if (gCpuTiles)
+    {
+        waterNodeRing = createBuffer(ctx.phys, ctx.device,
+                                     VkDeviceSize(VkContext::kMaxFrames * waterNodeCapacity) * sizeof(glm::vec4),
+                                     VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+                                     VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+        vkMapMemory(ctx.device, waterNodeRing.memory, 0, waterNodeRing.size, 0, (void **)&waterNodeRingMap);
+    }
+
     {
         std::vector<ParticleCPU> zeros;
         zeros.resize(MAX_PARTICLES);
@@ -2040,6 +2968,37 @@ int main(int argc, char **argv)
 
     uint32_t taaParity = 0;
 
+    // water.vert: N as in sizeSpec, whether it unprojects the screen grid instead of placing CDLOD
+    // nodes (constant_id 1), whether it only places them for water.tesc / water.tese (2), and the
+    // grid, morph and skirt constants (3..6)
+    struct WaterSpecData
+    {
+        uint32_t n;
+        VkBool32 projected;
+        VkBool32 tessellated;
+        float nodeGrid = float(kWaterNodeGrid);
+        float projGrid = float(kProjectedGrid);
+        float morphStart = kWaterMorphStart;
+        float skirtDepth = kWaterSkirtDepth;
+    };
+    const VkSpecializationMapEntry waterSpecEntries[7] = {
+        {0, offsetof(WaterSpecData, n), sizeof(uint32_t)},
+        {1, offsetof(WaterSpecData, projected), sizeof(VkBool32)},
+        {2, offsetof(WaterSpecData, tessellated), sizeof(VkBool32)},
+        {3, offsetof(WaterSpecData, nodeGrid), sizeof(float)},
+        {4, offsetof(WaterSpecData, projGrid), sizeof(float)},
+        {5, offsetof(WaterSpecData, morphStart), sizeof(float)},
+        {6, offsetof(WaterSpecData, skirtDepth), sizeof(float)},
+    };
+    const WaterSpecData waterTileSpecData{fftN, VK_FALSE, ctx.tessellation ? VK_TRUE : VK_FALSE};
+    const WaterSpecData waterProjSpecData{fftN, VK_TRUE, VK_FALSE};
+    const VkSpecializationInfo waterTileSpec{7, waterSpecEntries, sizeof(WaterSpecData), &waterTileSpecData};
+    const VkSpecializationInfo waterProjSpec{7, waterSpecEntries, sizeof(WaterSpecData), &waterProjSpecData};
+    const std::string waterVert = spv(gVertexless ? "water.vert.vertexless.spv" : "water.vert.spv");
+    const std::string waterTesc = ctx.tessellation ? spv("water.tesc.spv") : std::string();
+    const std::string waterTese = ctx.tessellation ? spv("water.tese.spv") : std::string();
+    const VkCompareOp waterCompare = gDepthPrepass ? VK_COMPARE_OP_EQUAL : VK_COMPARE_OP_LESS;
+
     try
     {
         // sky + water
@@ -2054,32 +3013,73 @@ int main(int argc, char **argv)
         // boat
         boatPipe = createGraphicsPipelineObjMesh(ctx.device, mainRenderPass, boatLayout, ctx.swapExtent,
                                                  spv("boat.vert.spv"), spv("boat.frag.spv"),
-                                                 true, VK_COMPARE_OP_LESS_OR_EQUAL,
+                                                 !gDepthPrepass, gDepthPrepass ? VK_COMPARE_OP_EQUAL : VK_COMPARE_OP_LESS_OR_EQUAL,
                                                  VK_POLYGON_MODE_FILL,
                                                  VK_CULL_MODE_NONE,
-                                                 true);
+                                                 true, false, &sizeSpec);
 
         waterFill = createGraphicsPipeline(ctx.device, mainRenderPass, waterLayout, ctx.swapExtent,
-                                           spv("water.vert.spv"), spv("water.frag.spv"),
-                                           true,
-                                           true, VK_COMPARE_OP_LESS,
+                                           waterVert, spv("water.frag.spv"),
+                                           !gVertexless,
+                                           !gDepthPrepass, waterCompare,
                                            VK_POLYGON_MODE_FILL,
                                            VK_CULL_MODE_NONE,
-                                           true);
+                                           true, false, &waterTileSpec, waterTesc, waterTese);
+
+        waterProjFill = createGraphicsPipeline(ctx.device, mainRenderPass, waterLayout, ctx.swapExtent,
+                                               waterVert, spv("water.frag.spv"),
+                                               !gVertexless,
+                                               !gDepthPrepass, waterCompare,
+                                               VK_POLYGON_MODE_FILL,
+                                               VK_CULL_MODE_NONE,
+                                               true, false, &waterProjSpec);
+
+        // same vertex stages as above (gl_Position invariant), no fragment stage
+        if (gDepthPrepass)
+        {
+            waterDepth = createGraphicsPipeline(ctx.device, mainRenderPass, waterLayout, ctx.swapExtent,
+                                                waterVert, std::string(),
+                                                !gVertexless,
+                                                true, VK_COMPARE_OP_LESS,
+                                                VK_POLYGON_MODE_FILL,
+                                                VK_CULL_MODE_NONE,
+                                                true, false, &waterTileSpec, waterTesc, waterTese);
+            waterProjDepth = createGraphicsPipeline(ctx.device, mainRenderPass, waterLayout, ctx.swapExtent,
+                                                    waterVert, std::string(),
+                                                    !gVertexless,
+                                                    true, VK_COMPARE_OP_LESS,
+                                                    VK_POLYGON_MODE_FILL,
+                                                    VK_CULL_MODE_NONE,
+                                                    true, false, &waterProjSpec);
+            boatDepth = createGraphicsPipelineObjMesh(ctx.device, mainRenderPass, boatLayout, ctx.swapExtent,
+                                                      spv("boat.vert.spv"), std::string(),
+                                                      true, VK_COMPARE_OP_LESS_OR_EQUAL,
+                                                      VK_POLYGON_MODE_FILL,
+                                                      VK_CULL_MODE_NONE,
+                                                      true, false, &sizeSpec);
+        }
 
         try
         {
             waterLine = createGraphicsPipeline(ctx.device, mainRenderPass, waterLayout, ctx.swapExtent,
-                                               spv("water.vert.spv"), spv("water.frag.spv"),
-                                               true,
+                                               waterVert, spv("water.frag.spv"),
+                                               !gVertexless,
                                                true, VK_COMPARE_OP_LESS,
                                                VK_POLYGON_MODE_LINE,
                                                VK_CULL_MODE_NONE,
-                                               true);
+                                               true, false, &waterTileSpec, waterTesc, waterTese);
+            waterProjLine = createGraphicsPipeline(ctx.device, mainRenderPass, waterLayout, ctx.swapExtent,
+                                                   waterVert, spv("water.frag.spv"),
+                                                   !gVertexless,
+                                                   true, VK_COMPARE_OP_LESS,
+                                                   VK_POLYGON_MODE_LINE,
+                                                   VK_CULL_MODE_NONE,
+                                                   true, false, &waterProjSpec);
         }
         catch (...)
         {
             waterLine = VK_NULL_HANDLE;
+            waterProjLine = VK_NULL_HANDLE;
         }
 
         // sporay
@@ -2123,62 +3123,48 @@ int main(int argc, char **argv)
         AllocatedBuffer vbo{};
         AllocatedBuffer ibo{};
         uint32_t indexCount = 0;
+        VkIndexType indexType = VK_INDEX_TYPE_UINT32; // uint16 when the vertices fit
     };
 
-    auto buildWaterMesh = [&](int GRID_N) -> WaterMesh
+    auto buildWaterMesh = [&](int GRID_N, bool skirts) -> WaterMesh
     {
         std::vector<MeshVert> verts;
-        verts.reserve((GRID_N + 1) * (GRID_N + 1) + (GRID_N + 1) * 4);
+        verts.reserve((GRID_N + 1) * (GRID_N + 1) + (skirts ? GRID_N * 4 : 0));
 
         auto idx = [GRID_N](int x, int z) -> uint32_t
         { return (uint32_t)(z * (GRID_N + 1) + x); };
 
+        // grid coords only, water.vert scales them to a unit node placed per instance (or the screen)
+        if (GRID_N >= kMeshVertSkirt)
+            throw std::runtime_error("water grid too fine for 16 bit vertices");
         for (int z = 0; z <= GRID_N; z++)
         {
             for (int x = 0; x <= GRID_N; x++)
             {
-                float u = (float)x / (float)GRID_N;
-                float v = (float)z / (float)GRID_N;
-                float px = (u - 0.5f) * PATCH_SIZE;
-                float pz = (v - 0.5f) * PATCH_SIZE;
                 MeshVert mv{};
-                mv.xz[0] = px;
-                mv.xz[1] = pz;
-                mv.uv[0] = u;
-                mv.uv[1] = v;
-                mv.skirt = 0.0f;
+                mv.grid[0] = (uint16_t)x;
+                mv.grid[1] = (uint16_t)z;
                 verts.push_back(mv);
             }
         }
 
-        // hide cracks by adding skirt at the edges
+        // skirt at the edges, dropped by water.vert only along the outer edge of the ocean; seams
+        // between nodes are closed by the morph. Numbered around the edge counter-clockwise from
+        // (0, 0), after the grid, so --vertexless can invert the index (gridVertex in water.vert)
         const uint32_t baseCount = (uint32_t)verts.size();
-        std::vector<int32_t> skirtMap(baseCount, -1);
-
-        auto addSkirt = [&](int x, int z)
+        for (int p = 0; p < (skirts ? GRID_N * 4 : 0); p++)
         {
-            uint32_t vi = idx(x, z);
-            if (skirtMap[vi] >= 0)
-                return;
-            MeshVert mv = verts[vi];
-            mv.skirt = 1.0f;
-            skirtMap[vi] = (int32_t)verts.size();
+            int side = p / GRID_N, t = p % GRID_N;
+            int x = side == 0 ? t : side == 1 ? GRID_N : side == 2 ? GRID_N - t : 0;
+            int z = side == 0 ? 0 : side == 1 ? t : side == 2 ? GRID_N : GRID_N - t;
+            MeshVert mv{};
+            mv.grid[0] = (uint16_t)x;
+            mv.grid[1] = (uint16_t)(z | kMeshVertSkirt);
             verts.push_back(mv);
-        };
-
-        for (int x = 0; x <= GRID_N; x++)
-        {
-            addSkirt(x, 0);
-            addSkirt(x, GRID_N);
-        }
-        for (int z = 0; z <= GRID_N; z++)
-        {
-            addSkirt(0, z);
-            addSkirt(GRID_N, z);
         }
 
         std::vector<uint32_t> indices;
-        indices.reserve(GRID_N * GRID_N * 6 + GRID_N * 4 * 6);
+        indices.reserve(GRID_N * GRID_N * 6 + (skirts ? GRID_N * 4 * 6 : 0));
 
         for (int z = 0; z < GRID_N; z++)
         {
@@ -2197,94 +3183,122 @@ int main(int argc, char **argv)
             }
         }
 
-        auto skirtOf = [&](int x, int z) -> uint32_t
+        if (skirts)
         {
-            uint32_t vi = idx(x, z);
-            return (uint32_t)skirtMap[vi];
-        };
+            auto skirtOf = [&](int x, int z) -> uint32_t
+            {
+                int p = z == 0 ? x : x == GRID_N ? GRID_N + z : z == GRID_N ? GRID_N * 3 - x : GRID_N * 4 - z;
+                return baseCount + (uint32_t)p;
+            };
 
-        // bot edge
-        for (int x = 0; x < GRID_N; x++)
-        {
-            uint32_t t0 = idx(x, 0), t1 = idx(x + 1, 0);
-            uint32_t b0 = skirtOf(x, 0), b1 = skirtOf(x + 1, 0);
-            indices.push_back(t0);
-            indices.push_back(b0);
-            indices.push_back(t1);
-            indices.push_back(t1);
-            indices.push_back(b0);
-            indices.push_back(b1);
-        }
-        // top edge
-        for (int x = 0; x < GRID_N; x++)
-        {
-            uint32_t t0 = idx(x, GRID_N), t1 = idx(x + 1, GRID_N);
-            uint32_t b0 = skirtOf(x, GRID_N), b1 = skirtOf(x + 1, GRID_N);
-            indices.push_back(t1);
-            indices.push_back(b0);
-            indices.push_back(t0);
-            indices.push_back(b1);
-            indices.push_back(b0);
-            indices.push_back(t1);
-        }
-        // left
-        for (int z = 0; z < GRID_N; z++)
-        {
-            uint32_t t0 = idx(0, z), t1 = idx(0, z + 1);
-            uint32_t b0 = skirtOf(0, z), b1 = skirtOf(0, z + 1);
-            indices.push_back(t1);
-            indices.push_back(b0);
-            indices.push_back(t0);
-            indices.push_back(b1);
-            indices.push_back(b0);
-            indices.push_back(t1);
-        }
-        // right
-        for (int z = 0; z < GRID_N; z++)
-        {
-            uint32_t t0 = idx(GRID_N, z), t1 = idx(GRID_N, z + 1);
-            uint32_t b0 = skirtOf(GRID_N, z), b1 = skirtOf(GRID_N, z + 1);
-            indices.push_back(t0);
-            indices.push_back(b0);
-            indices.push_back(t1);
-            indices.push_back(t1);
-            indices.push_back(b0);
-            indices.push_back(b1);
+            // bot edge
+            for (int x = 0; x < GRID_N; x++)
+            {
+                uint32_t t0 = idx(x, 0), t1 = idx(x + 1, 0);
+                uint32_t b0 = skirtOf(x, 0), b1 = skirtOf(x + 1, 0);
+                indices.push_back(t0);
+                indices.push_back(b0);
+                indices.push_back(t1);
+                indices.push_back(t1);
+                indices.push_back(b0);
+                indices.push_back(b1);
+            }
+            // top edge
+            for (int x = 0; x < GRID_N; x++)
+            {
+                uint32_t t0 = idx(x, GRID_N), t1 = idx(x + 1, GRID_N);
+                uint32_t b0 = skirtOf(x, GRID_N), b1 = skirtOf(x + 1, GRID_N);
+                indices.push_back(t1);
+                indices.push_back(b0);
+                indices.push_back(t0);
+                indices.push_back(b1);
+                indices.push_back(b0);
+                indices.push_back(t1);
+            }
+            // left
+            for (int z = 0; z < GRID_N; z++)
+            {
+                uint32_t t0 = idx(0, z), t1 = idx(0, z + 1);
+                uint32_t b0 = skirtOf(0, z), b1 = skirtOf(0, z + 1);
+                indices.push_back(t1);
+                indices.push_back(b0);
+                indices.push_back(t0);
+                indices.push_back(b1);
+                indices.push_back(b0);
+                indices.push_back(t1);
+            }
+            // right
+            for (int z = 0; z < GRID_N; z++)
+            {
+                uint32_t t0 = idx(GRID_N, z), t1 = idx(GRID_N, z + 1);
+                uint32_t b0 = skirtOf(GRID_N, z), b1 = skirtOf(GRID_N, z + 1);
+                indices.push_back(t0);
+                indices.push_back(b0);
+                indices.push_back(t1);
+                indices.push_back(t1);
+                indices.push_back(b0);
+                indices.push_back(b1);
+            }
         }
 
+        optimizeMeshIndices("water grid " + std::to_string(GRID_N), indices, (uint32_t)verts.size());
+
         WaterMesh out{};
         out.indexCount = (uint32_t)indices.size();
 
-        out.vbo = createBuffer(ctx.phys, ctx.device,
-                               VkDeviceSize(verts.size() * sizeof(MeshVert)),
-                               VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
-                               VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+        // half the index bytes for every grid under 65536 vertices: the node mesh, not the projected
+        // grid, whose 385^2 vertices exceed it even without skirts
+        std::vector<uint16_t> indices16;
+        if (verts.size() <= 65536)
+        {
+            out.indexType = VK_INDEX_TYPE_UINT16;
+            indices16.assign(indices.begin(), indices.end());
+        }
+        const void *indexData = indices16.empty() ? (const void *)indices.data() : (const void *)indices16.data();
+        const size_t indexSize = indices16.empty() ? sizeof(uint32_t) : sizeof(uint16_t);
+
+        // --vertexless: the vertex list only exists here, to order the indices
+        if (!gVertexless)
+        {
+            out.vbo = createBuffer(ctx.phys, ctx.device,
+                                   VkDeviceSize(verts.size() * sizeof(MeshVert)),
+                                   VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+                                   VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+        }
 
         out.ibo = createBuffer(ctx.phys, ctx.device,
-                               VkDeviceSize(indices.size() * sizeof(uint32_t)),
+                               VkDeviceSize(indices.size() * indexSize),
                                VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
                                VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
 
         {
             VkDeviceSize vSize = out.vbo.size;
             VkDeviceSize iSize = out.ibo.size;
-            AllocatedBuffer stV = createBuffer(ctx.phys, ctx.device, vSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-                                               VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+            AllocatedBuffer stV{};
+            if (vSize > 0)
+                stV = createBuffer(ctx.phys, ctx.device, vSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+                                   VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
             AllocatedBuffer stI = createBuffer(ctx.phys, ctx.device, iSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
                                                VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
 
             void *map = nullptr;
-            vkMapMemory(ctx.device, stV.memory, 0, vSize, 0, &map);
-            std::memcpy(map, verts.data(), (size_t)vSize);
-            vkUnmapMemory(ctx.device, stV.memory);
+            if (vSize > 0)
+            {
+                vkMapMemory(ctx.device, stV.memory, 0, vSize, 0, &map);
+                std::memcpy(map, verts.data(), (size_t)vSize);
+                vkUnmapMemory(ctx.device, stV.memory);
+            }
 
             vkMapMemory(ctx.device, stI.memory, 0, iSize, 0, &map);
-            std::memcpy(map, indices.data(), (size_t)iSize);
+            std::memcpy(map, indexData, (size_t)iSize);
             vkUnmapMemory(ctx.device, stI.memory);
 
             VkCommandBuffer cmd = beginSingleTimeCommands(ctx.device, ctx.cmdPool);
-            VkBufferCopy vc{0, 0, vSize};
-            vkCmdCopyBuffer(cmd, stV.buffer, out.vbo.buffer, 1, &vc);
+            if (vSize > 0)
+            {
+                VkBufferCopy vc{0, 0, vSize};
+                vkCmdCopyBuffer(cmd, stV.buffer, out.vbo.buffer, 1, &vc);
+            }
             VkBufferCopy ic{0, 0, iSize};
             vkCmdCopyBuffer(cmd, stI.buffer, out.ibo.buffer, 1, &ic);
             endSingleTimeCommands(ctx.device, ctx.graphicsQ, ctx.cmdPool, cmd);
@@ -2296,10 +3310,10 @@ int main(int argc, char **argv)
         return out;
     };
 
-    // water mesh
-    WaterMesh meshHi = buildWaterMesh(256);
-    WaterMesh meshMid = buildWaterMesh(128);
-    WaterMesh meshLo = buildWaterMesh(64);
+    // water mesh, one per quadtree node, and the screen grid of the projected mode, which needs no
+    // skirts: it ends at the screen edge
+    WaterMesh meshNode = buildWaterMesh(kWaterNodeGrid, true);
+    WaterMesh meshProjected = buildWaterMesh(kProjectedGrid, false);
 
     // duck obj mesh
     struct ObjMesh
@@ -2347,6 +3361,7 @@ int main(int argc, char **argv)
             }
         }
 
+        optimizeMeshIndices("duck", inds, (uint32_t)verts.size());
         duckMesh.indexCount = (uint32_t)inds.size();
 
         duckMesh.vbo = createBuffer(ctx.phys, ctx.device,
@@ -2431,13 +3446,13 @@ int main(int argc, char **argv)
 
         VkDescriptorImageInfo fft{};
         fft.sampler = fftSampler;
-        fft.imageView = texBCombined.view;
+        fft.imageView = texDisp.view;
         fft.imageLayout = VK_IMAGE_LAYOUT_GENERAL;
 
-        VkDescriptorImageInfo fftDetail{};
-        fftDetail.sampler = fftSampler;
-        fftDetail.imageView = texB0_1.view;
-        fftDetail.imageLayout = VK_IMAGE_LAYOUT_GENERAL;
+        VkDescriptorImageInfo deriv{};
+        deriv.sampler = fftSampler;
+        deriv.imageView = texDeriv.view;
+        deriv.imageLayout = VK_IMAGE_LAYOUT_GENERAL;
 
         VkDescriptorImageInfo hdr{};
         hdr.sampler = hdrSampler;
@@ -2455,6 +3470,11 @@ int main(int argc, char **argv)
         sdepth.imageView = sceneDepth.view;
         sdepth.imageLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL;
 
+        VkDescriptorBufferInfo tiles{};
+        tiles.buffer = gCpuTiles ? waterNodeRing.buffer : waterNodeBuf.buffer;
+        tiles.offset = 0;
+        tiles.range = VK_WHOLE_SIZE;
+
         for (int i = 0; i < 2; i++)
         {
             vkAllocateDescriptorSets(ctx.device, &ai, &texSet[i]);
@@ -2469,7 +3489,7 @@ int main(int argc, char **argv)
             wake.imageView = foamImg[i].view;
             wake.imageLayout = VK_IMAGE_LAYOUT_GENERAL;
 
-            std::array<VkWriteDescriptorSet, 7> wr{};
+            std::array<VkWriteDescriptorSet, 8> wr{};
             wr[0] = {VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET};
             wr[0].dstSet = texSet[i];
             wr[0].dstBinding = 0;
@@ -2507,17 +3527,24 @@ int main(int argc, char **argv)
 
             wr[5] = {VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET};
             wr[5].dstSet = texSet[i];
-            wr[5].dstBinding = 5;
+            wr[5].dstBinding = 6;
             wr[5].descriptorCount = 1;
             wr[5].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-            wr[5].pImageInfo = &fftDetail;
+            wr[5].pImageInfo = &wake;
 
             wr[6] = {VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET};
             wr[6].dstSet = texSet[i];
-            wr[6].dstBinding = 6;
+            wr[6].dstBinding = 5;
             wr[6].descriptorCount = 1;
             wr[6].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-            wr[6].pImageInfo = &wake;
+            wr[6].pImageInfo = &deriv;
+
+            wr[7] = {VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET};
+            wr[7].dstSet = texSet[i];
+            wr[7].dstBinding = 7;
+            wr[7].descriptorCount = 1;
+            wr[7].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+            wr[7].pBufferInfo = &tiles;
 
             vkUpdateDescriptorSets(ctx.device, (uint32_t)wr.size(), wr.data(), 0, nullptr);
         }
@@ -2655,14 +3682,9 @@ int main(int argc, char **argv)
 
         VkDescriptorImageInfo fft{};
         fft.sampler = fftSampler;
-        fft.imageView = texBCombined.view;
+        fft.imageView = texDisp.view;
         fft.imageLayout = VK_IMAGE_LAYOUT_GENERAL;
 
-        VkDescriptorImageInfo fftDetail{};
-        fftDetail.sampler = fftSampler;
-        fftDetail.imageView = texB0_1.view;
-        fftDetail.imageLayout = VK_IMAGE_LAYOUT_GENERAL;
-
         VkDescriptorBufferInfo biP{};
         biP.buffer = sprayBuf.buffer;
         biP.offset = 0;
@@ -2673,7 +3695,12 @@ int main(int argc, char **argv)
         biC.offset = 0;
         biC.range = sizeof(uint32_t);
 
-        std::array<VkWriteDescriptorSet, 3> wr{};
+        VkDescriptorImageInfo deriv{};
+        deriv.sampler = fftSampler;
+        deriv.imageView = texDeriv.view;
+        deriv.imageLayout = VK_IMAGE_LAYOUT_GENERAL;
+
+        std::array<VkWriteDescriptorSet, 4> wr{};
         wr[0] = {VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET};
         wr[0].dstSet = dsSpray;
         wr[0].dstBinding = 0;
@@ -2695,13 +3722,47 @@ int main(int argc, char **argv)
         wr[2].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
         wr[2].pBufferInfo = &biC;
 
+        wr[3] = {VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET};
+        wr[3].dstSet = dsSpray;
+        wr[3].dstBinding = 3;
+        wr[3].descriptorCount = 1;
+        wr[3].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+        wr[3].pImageInfo = &deriv;
+
         vkUpdateDescriptorSets(ctx.device, (uint32_t)wr.size(), wr.data(), 0, nullptr);
     }
 
-    // compute descriptor sets
-    VkDescriptorSet dsSpectrum0{}, dsBuild0{}, dsRows0{}, dsCols0{};
-    VkDescriptorSet dsSpectrum1{}, dsBuild1{}, dsRows1{}, dsCols1{};
-    VkDescriptorSet dsCombine{};
+    // water node culling set
+    VkDescriptorSet dsWaterCull{};
+    {
+        VkDescriptorSetAllocateInfo ai{VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO};
+        ai.descriptorPool = compPool;
+        ai.descriptorSetCount = 1;
+        ai.pSetLayouts = &compWaterCullSetLayout;
+        vkAllocateDescriptorSets(ctx.device, &ai, &dsWaterCull);
+
+        VkDescriptorBufferInfo bi[2]{};
+        bi[0] = {waterDrawBuf.buffer, 0, waterDrawBuf.size};
+        bi[1] = {waterNodeBuf.buffer, 0, waterNodeBuf.size};
+        VkWriteDescriptorSet wr[2]{};
+        for (uint32_t i = 0; i < 2; i++)
+        {
+            wr[i] = {VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET};
+            wr[i].dstSet = dsWaterCull;
+            wr[i].dstBinding = i;
+            wr[i].descriptorCount = 1;
+            wr[i].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+            wr[i].pBufferInfo = &bi[i];
+        }
+        vkUpdateDescriptorSets(ctx.device, 2, wr, 0, nullptr);
+    }
+
+    // compute descriptor sets, every image is the array of all bands
+    VkDescriptorSet dsSpectrumInit{};
+    VkDescriptorSet dsSpectrum{}, dsBuild{}, dsRows{}, dsCols{}, dsDispPack{}, dsDispPackRef{};
+    std::vector<VkDescriptorSet> dsDispMip(dispMips), dsDerivMip(dispMips); // [m] = mip m - 1 -> m, [0] unused
+    VkDescriptorSet dsTwiddle{};
+    VkDescriptorSet dsFusedRows{};
     VkDescriptorSet dsFoam[2]{};
     auto allocCompSet = [&](VkDescriptorSetLayout layout, VkDescriptorSet &out)
     {
@@ -2712,38 +3773,61 @@ int main(int argc, char **argv)
         vkAllocateDescriptorSets(ctx.device, &ai, &out);
     };
 
-    // two FFT bands
-    allocCompSet(compSpectrumSetLayout, dsSpectrum0);
-    allocCompSet(comp2ImgSetLayout, dsBuild0);
-    allocCompSet(comp2ImgSetLayout, dsRows0);
-    allocCompSet(comp2ImgSetLayout, dsCols0);
-
-    allocCompSet(compSpectrumSetLayout, dsSpectrum1);
-    allocCompSet(comp2ImgSetLayout, dsBuild1);
-    allocCompSet(comp2ImgSetLayout, dsRows1);
-    allocCompSet(comp2ImgSetLayout, dsCols1);
-
-    allocCompSet(comp3ImgSetLayout, dsCombine);
-
-    allocCompSet(compFoamSetLayout, dsFoam[0]);
-    allocCompSet(compFoamSetLayout, dsFoam[1]);
-    auto writeSpectrum = [&](VkDescriptorSet set, VkImageView outView)
+    allocCompSet(comp2ImgSetLayout, dsSpectrumInit);
+    allocCompSet(compSpectrumSetLayout, dsSpectrum);
+    allocCompSet(comp2ImgSetLayout, dsBuild);
+    allocCompSet(comp2ImgSetLayout, dsRows);
+    allocCompSet(comp2ImgSetLayout, dsCols);
+    allocCompSet(compDispPackSetLayout, dsDispPack);
+    for (uint32_t m = 1; m < dispMips; ++m)
     {
-        VkDescriptorImageInfo outH{};
-        outH.imageView = outView;
-        outH.imageLayout = VK_IMAGE_LAYOUT_GENERAL;
+        allocCompSet(comp2ImgSetLayout, dsDispMip[m]);
+        allocCompSet(comp2ImgSetLayout, dsDerivMip[m]);
+    }
+    if (gFftValidate)
+        allocCompSet(compDispPackSetLayout, dsDispPackRef);
+    allocCompSet(compSpectrumSetLayout, dsFusedRows);
 
+    allocCompSet(twiddleSetLayout, dsTwiddle);
+    {
+        VkDescriptorBufferInfo bi{};
+        bi.buffer = twiddleBuf.buffer;
+        bi.offset = 0;
+        bi.range = twiddleBuf.size;
         VkWriteDescriptorSet w{VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET};
-        w.dstSet = set;
+        w.dstSet = dsTwiddle;
         w.dstBinding = 0;
         w.descriptorCount = 1;
-        w.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
-        w.pImageInfo = &outH;
+        w.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        w.pBufferInfo = &bi;
         vkUpdateDescriptorSets(ctx.device, 1, &w, 0, nullptr);
+    }
+
+    allocCompSet(compFoamSetLayout, dsFoam[0]);
+    allocCompSet(compFoamSetLayout, dsFoam[1]);
+    auto writeSpectrum = [&](VkDescriptorSet set, VkImageView outView)
+    {
+        VkImageView views[3] = {outView, texH0Cache.view, texOmega.view};
+        VkDescriptorImageInfo ii[3]{};
+        VkWriteDescriptorSet wr[3]{};
+        for (uint32_t i = 0; i < 3; i++)
+        {
+            ii[i].imageView = views[i];
+            ii[i].imageLayout = VK_IMAGE_LAYOUT_GENERAL;
+            wr[i] = {VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET};
+            wr[i].dstSet = set;
+            wr[i].dstBinding = i;
+            wr[i].descriptorCount = 1;
+            wr[i].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+            wr[i].pImageInfo = &ii[i];
+        }
+        vkUpdateDescriptorSets(ctx.device, 3, wr, 0, nullptr);
     };
 
-    writeSpectrum(dsSpectrum0, texH0.view);
-    writeSpectrum(dsSpectrum1, texH1.view);
+    writeSpectrum(dsSpectrum, texH.view);
+
+    // fused path: rows land in B1, the cols (dsCols) write the fields into B0
+    writeSpectrum(dsFusedRows, texB1.view);
 
     auto write2 = [&](VkDescriptorSet set, VkImageView src, VkImageView dst)
     {
@@ -2769,65 +3853,47 @@ int main(int argc, char **argv)
         vkUpdateDescriptorSets(ctx.device, 2, ws, 0, nullptr);
     };
 
-    // 0 swell
-    write2(dsBuild0, texH0.view, texB0_0.view);
-    write2(dsRows0, texB0_0.view, texB1_0.view);
-    write2(dsCols0, texB1_0.view, texB0_0.view);
-
-    // 1 wind
-    write2(dsBuild1, texH1.view, texB0_1.view);
-    write2(dsRows1, texB0_1.view, texB1_1.view);
-    write2(dsCols1, texB1_1.view, texB0_1.view);
-
-    // combine
+    write2(dsSpectrumInit, texH0Cache.view, texOmega.view);
+    write2(dsBuild, texH.view, texB0.view);
+    write2(dsRows, texB0.view, texB1.view);
+    write2(dsCols, texB1.view, texB0.view);
+    auto writeDispPack = [&](VkDescriptorSet set, VkImageView dispView, VkImageView derivView)
     {
-        VkDescriptorImageInfo a{};
-        a.imageView = texB0_0.view;
-        a.imageLayout = VK_IMAGE_LAYOUT_GENERAL;
-        VkDescriptorImageInfo b{};
-        b.imageView = texB0_1.view;
-        b.imageLayout = VK_IMAGE_LAYOUT_GENERAL;
-        VkDescriptorImageInfo o{};
-        o.imageView = texBCombined.view;
-        o.imageLayout = VK_IMAGE_LAYOUT_GENERAL;
-
-        std::array<VkWriteDescriptorSet, 3> wr{};
-        wr[0] = {VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET};
-        wr[0].dstSet = dsCombine;
-        wr[0].dstBinding = 0;
-        wr[0].descriptorCount = 1;
-        wr[0].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
-        wr[0].pImageInfo = &a;
-
-        wr[1] = {VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET};
-        wr[1].dstSet = dsCombine;
-        wr[1].dstBinding = 1;
-        wr[1].descriptorCount = 1;
-        wr[1].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
-        wr[1].pImageInfo = &b;
-
-        wr[2] = {VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET};
-        wr[2].dstSet = dsCombine;
-        wr[2].dstBinding = 2;
-        wr[2].descriptorCount = 1;
-        wr[2].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
-        wr[2].pImageInfo = &o;
+        VkImageView views[3] = {texB0.view, dispView, derivView};
+        VkDescriptorImageInfo ii[3]{};
+        VkWriteDescriptorSet wr[3]{};
+        for (uint32_t i = 0; i < 3; i++)
+        {
+            ii[i].imageView = views[i];
+            ii[i].imageLayout = VK_IMAGE_LAYOUT_GENERAL;
+            wr[i] = {VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET};
+            wr[i].dstSet = set;
+            wr[i].dstBinding = i;
+            wr[i].descriptorCount = 1;
+            wr[i].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+            wr[i].pImageInfo = &ii[i];
+        }
+        vkUpdateDescriptorSets(ctx.device, 3, wr, 0, nullptr);
+    };
 
-        vkUpdateDescriptorSets(ctx.device, (uint32_t)wr.size(), wr.data(), 0, nullptr);
+    writeDispPack(dsDispPack, dispMipViews[0], derivMipViews[0]);
+    for (uint32_t m = 1; m < dispMips; ++m)
+    {
+        write2(dsDispMip[m], dispMipViews[m - 1], dispMipViews[m]);
+        write2(dsDerivMip[m], derivMipViews[m - 1], derivMipViews[m]);
     }
+    // the reference pack never writes uDeriv (DERIV off), but the binding is declared rgba32f, which
+    // the derivative map is not at fp16, so it gets the reference image again
+    if (gFftValidate)
+        writeDispPack(dsDispPackRef, texDispRef.view, texDispRef.view);
 
     auto writeFoam = [&](VkDescriptorSet set, VkImageView prevFoam, VkImageView outFoam)
     {
         VkDescriptorImageInfo fft{};
         fft.sampler = fftSampler;
-        fft.imageView = texBCombined.view;
+        fft.imageView = texDisp.view;
         fft.imageLayout = VK_IMAGE_LAYOUT_GENERAL;
 
-        VkDescriptorImageInfo fftDetail{};
-        fftDetail.sampler = fftSampler;
-        fftDetail.imageView = texB0_1.view;
-        fftDetail.imageLayout = VK_IMAGE_LAYOUT_GENERAL;
-
         VkDescriptorImageInfo prev{};
         prev.sampler = foamSampler;
         prev.imageView = prevFoam;
@@ -2838,6 +3904,11 @@ int main(int argc, char **argv)
         out.imageView = outFoam;
         out.imageLayout = VK_IMAGE_LAYOUT_GENERAL;
 
+        VkDescriptorImageInfo deriv{};
+        deriv.sampler = fftSampler;
+        deriv.imageView = texDeriv.view;
+        deriv.imageLayout = VK_IMAGE_LAYOUT_GENERAL;
+
         VkWriteDescriptorSet w0{VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET};
         w0.dstSet = set;
         w0.dstBinding = 0;
@@ -2856,18 +3927,172 @@ int main(int argc, char **argv)
         w2.descriptorCount = 1;
         w2.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
         w2.pImageInfo = &out;
-
-        VkWriteDescriptorSet ws[3]{w0, w1, w2};
-        vkUpdateDescriptorSets(ctx.device, 3, ws, 0, nullptr);
+        VkWriteDescriptorSet w3{VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET};
+        w3.dstSet = set;
+        w3.dstBinding = 3;
+        w3.descriptorCount = 1;
+        w3.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+        w3.pImageInfo = &deriv;
+
+        VkWriteDescriptorSet ws[4]{w0, w1, w2, w3};
+        vkUpdateDescriptorSets(ctx.device, 4, ws, 0, nullptr);
     };
 
     writeFoam(dsFoam[0], foamImg[0].view, foamImg[1].view);
     writeFoam(dsFoam[1], foamImg[1].view, foamImg[0].view);
 
+    VkDescriptorSet dsValidate{};
+    if (gFftValidate)
+    {
+        allocCompSet(compValidateSetLayout, dsValidate);
+
+        VkDescriptorImageInfo disp{};
+        disp.sampler = fftSampler;
+        disp.imageView = texDisp.view;
+        disp.imageLayout = VK_IMAGE_LAYOUT_GENERAL;
+
+        VkDescriptorImageInfo ref{};
+        ref.sampler = fftSampler;
+        ref.imageView = texDispRef.view;
+        ref.imageLayout = VK_IMAGE_LAYOUT_GENERAL;
+
+        VkDescriptorBufferInfo bi{};
+        bi.buffer = validateBuf.buffer;
+        bi.offset = 0;
+        bi.range = VK_WHOLE_SIZE;
+
+        std::array<VkWriteDescriptorSet, 3> wr{};
+        wr[0] = {VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET};
+        wr[0].dstSet = dsValidate;
+        wr[0].dstBinding = 0;
+        wr[0].descriptorCount = 1;
+        wr[0].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+        wr[0].pImageInfo = &disp;
+
+        wr[1] = {VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET};
+        wr[1].dstSet = dsValidate;
+        wr[1].dstBinding = 1;
+        wr[1].descriptorCount = 1;
+        wr[1].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+        wr[1].pImageInfo = &ref;
+
+        wr[2] = {VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET};
+        wr[2].dstSet = dsValidate;
+        wr[2].dstBinding = 2;
+        wr[2].descriptorCount = 1;
+        wr[2].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        wr[2].pBufferInfo = &bi;
+
+        vkUpdateDescriptorSets(ctx.device, (uint32_t)wr.size(), wr.data(), 0, nullptr);
+    }
+
+    // per band lanes for the kernels and the GlobalUBO, lanes past kBandCount stay 0
+    glm::vec4 bandPatch(0.0f), bandDisp(0.0f), bandNormal(0.0f), bandFade(0.0f), foamBandWeight(0.0f);
+    for (uint32_t b = 0; b < kBandCount; ++b)
+    {
+        const OceanBand &band = kOceanBands[b];
+        bandPatch[b] = band.patchSize;
+        bandDisp[b] = band.dispWeight;
+        bandNormal[b] = band.normalWeight;
+        bandFade[b] = band.fadeDist;
+        // foam and spray run on the PATCH_SIZE texel grid, so they only see the bands on it
+        if (band.patchSize == PATCH_SIZE)
+            foamBandWeight[b] = band.dispWeight;
+    }
+
+    // --band-rates: update interval of each band in simulation steps, and its offset so bands on
+    // the same interval take turns. Blending two states loses the most on the band's fastest wave
+    // (kMax, or the Nyquist wave number of its patch), so the band whose fastest wave is fastest
+    // updates every step and the rest by how many times slower theirs is, rounded down to a power
+    // of two. w = sqrt(g k) does not depend on the wind, so this is fixed for the run
+    uint32_t bandInterval[kMaxBands]{};
+    uint32_t bandPhase[kMaxBands]{};
+    {
+        float omegaTop[kMaxBands]{};
+        float omegaMax = 0.0f;
+        for (uint32_t b = 0; b < kBandCount; ++b)
+        {
+            const OceanBand &band = kOceanBands[b];
+            float kTop = kTwoPi / band.patchSize * float(fftN / 2);
+            if (band.kMax > 0.0f)
+                kTop = std::min(kTop, band.kMax);
+            omegaTop[b] = std::sqrt(9.81f * kTop);
+            omegaMax = std::max(omegaMax, omegaTop[b]);
+        }
+        uint32_t onInterval[kMaxBandInterval + 1]{};
+        for (uint32_t b = 0; b < kBandCount; ++b)
+        {
+            uint32_t n = 1;
+            while (gBandRates && n * 2 <= kMaxBandInterval && omegaTop[b] * float(n * 2) <= omegaMax)
+                n *= 2;
+            bandInterval[b] = n;
+            bandPhase[b] = onInterval[n]++ % n;
+        }
+        if (gBandRates)
+        {
+            std::cout << "Band update intervals (steps):";
+            for (uint32_t b = 0; b < kBandCount; ++b)
+                std::cout << " " << bandInterval[b];
+            std::cout << "\n";
+        }
+    }
+
+    // --fft-validate results, max over the frames since the last print
+    float fftMaxErr[kMaxBands]{};
+    float fftMaxRef[kMaxBands]{};
+    bool validatePending[VkContext::kMaxFrames]{};
+    const auto printFftValidation = [&]()
+    {
+        std::cout << "FFT " << (gFftHalf ? "fp16" : "fp32") << " vs fp32 max |error| per band:";
+        for (uint32_t b = 0; b < kBandCount; ++b)
+        {
+            std::cout << " " << fftMaxErr[b];
+            if (fftMaxRef[b] > 0.0f)
+                std::cout << " (" << (fftMaxErr[b] / fftMaxRef[b] * 100.0f) << "% of max)";
+        }
+        std::cout << "\n";
+    };
+
+    // --cpu-tiles: wall time of the quadtree walk, which records no GPU work; since the last print
+    double cpuCullMsSum = 0.0;
+    double cpuCullMsMax = 0.0;
+    uint32_t cpuCullFrames = 0;
+
+    auto printTimings = [&]()
+    {
+        profiler.printSummary(std::cout);
+        if (ctx.asyncCompute)
+        {
+            std::cout << "Async compute queue:\n";
+            computeProfiler.printSummary(std::cout);
+        }
+        if (cpuCullFrames > 0)
+        {
+            std::cout << "CPU water cull (ms, last " << cpuCullFrames << " frames): avg "
+                      << (cpuCullMsSum / cpuCullFrames) << "  max " << cpuCullMsMax << "\n";
+            cpuCullMsSum = cpuCullMsMax = 0.0;
+            cpuCullFrames = 0;
+        }
+    };
+
+    // height deviation of the current spectrum, for the water cull; updated with the h0 cache
+    float waveSigma = spectrumSigma(gWindAngle, gSpectrumAmpScale, gWindSpeedScale);
+
     float time = 0.0f;
     float dbgTimer = 0.0f;
     uint32_t foamParity = 0;
 
+    // simulation schedule: the last simulation step (a frame, or a --sim-rate step) and the wave
+    // time it was taken at, and per band the slots and times of its two newest simulated states
+    int64_t simStep = -1;
+    float simStepTime = 0.0f;
+    struct BandSim
+    {
+        uint32_t older = 0, newer = 0;
+        double tOlder = 0.0, tNewer = 0.0;
+    };
+    BandSim bandSim[kMaxBands]{};
+
     // init boat, still under maybe put it more infront
     if (glm::length(gBoatPos) < 0.001f)
     {
@@ -2890,14 +4115,28 @@ int main(int argc, char **argv)
     glm::mat4 prevVP = glm::mat4(1.0f);
     bool hasPrevVP = false;
 
-    while (!glfwWindowShouldClose(window))
+    int frameCount = 0;
+    uint32_t lastImageIndex = 0;
+    auto runStart = std::chrono::steady_clock::now();
+
+    while ((!window || !glfwWindowShouldClose(window)) && (gMaxFrames == 0 || frameCount < gMaxFrames))
     {
-        float currentFrame = (float)glfwGetTime();
-        deltaTime = currentFrame - lastFrame;
-        lastFrame = currentFrame;
+        if (gFixedDt > 0.0f)
+        {
+            deltaTime = gFixedDt;
+        }
+        else
+        {
+            float currentFrame = (float)glfwGetTime();
+            deltaTime = currentFrame - lastFrame;
+            lastFrame = currentFrame;
+        }
 
-        processInput(window, deltaTime);
-        glfwPollEvents();
+        if (window)
+        {
+            processInput(window, deltaTime);
+            glfwPollEvents();
+        }
 
         time += deltaTime * gWaveSpeed;
 
@@ -2916,6 +4155,35 @@ int main(int argc, char **argv)
         if (cmd == VK_NULL_HANDLE)
             continue;
 
+        // async compute: the simulation is recorded into the compute queue's buffer and submitted
+        // ahead of this one, which waits for it; otherwise it leads the graphics buffer
+        VkCommandBuffer simCmd = ctx.asyncCompute ? ctx.beginCompute() : cmd;
+        GpuProfiler &simProfiler = ctx.asyncCompute ? computeProfiler : profiler;
+
+        profiler.beginFrame(ctx.device, cmd, ctx.frameIndex);
+        if (ctx.asyncCompute)
+            computeProfiler.beginFrame(ctx.device, simCmd, ctx.frameIndex);
+
+        // --fft-validate: this slot's fence has been waited on, fold its result in and reset it
+        if (gFftValidate)
+        {
+            uint32_t *r = validateMap + ctx.frameIndex * 8;
+            if (validatePending[ctx.frameIndex])
+            {
+                for (uint32_t b = 0; b < kBandCount; ++b)
+                {
+                    float err = 0.0f, ref = 0.0f;
+                    std::memcpy(&err, &r[b], sizeof(float));
+                    std::memcpy(&ref, &r[4 + b], sizeof(float));
+                    fftMaxErr[b] = std::max(fftMaxErr[b], err);
+                    fftMaxRef[b] = std::max(fftMaxRef[b], ref);
+                }
+            }
+            std::memset(r, 0, 8 * sizeof(uint32_t));
+            validatePending[ctx.frameIndex] = true;
+        }
+        profiler.begin(cmd, "frame");
+
         if (ctx.renderPass != lastSwapRenderPass)
         {
             vkDeviceWaitIdle(ctx.device);
@@ -3032,123 +4300,322 @@ int main(int argc, char **argv)
             lastExtent = ctx.swapExtent;
         }
 
-        // FFT chain
-        float invN = 1.0f / float(FREQ_SIZE);
-        struct alignas(8)
-        {
-            float invN;
-            float finalScale;
-        } ipc{};
-        ipc.invN = invN;
-        ipc.finalScale = 25.0f;
+        uint32_t foamRead = foamParity;
+        uint32_t foamWrite = 1u - foamRead;
 
-        auto runFFTBand = [&](VkDescriptorSet dsSpec, VkDescriptorSet dsB, VkDescriptorSet dsR, VkDescriptorSet dsC,
-                              AllocatedImage &H, AllocatedImage &B0, AllocatedImage &B1,
-                              float windX, float windY, float amp, float windSpeed,
-                              float patchSize, float seed)
+        // Simulation step k: every frame, or with --sim-rate fixed steps of wave time, step k
+        // covering [k - 1, k) * stepLen and simulated one step ahead. A band due on step k
+        // (every bandInterval steps, at bandPhase) is simulated at the start of its next due step
+        // and blended from its previous state until then, so every band passes through the current
+        // time. Frame steps are instants, their length predicted from the last one. A band whose
+        // newest state is already behind the current time (steps skipped by a slow frame, or a
+        // restart) catches up to the start of its next due step. On the first step and after a
+        // spectrum change every band restarts from a state at the current time
+        uint32_t simMask = 0;      // bands simulated this frame
+        glm::vec4 bandTime(0.0f);  // ... at these wave times
+        glm::ivec4 bandWrite(0);   // ... into these layers
         {
-            vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, csSpectrum);
-            vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, compSpectrumLayout, 0, 1, &dsSpec, 0, nullptr);
-
-            struct alignas(16)
+            const bool fixedRate = gSimRate > 0.0f;
+            const double stepLen = fixedRate ? 1.0 / double(gSimRate) : double(time - simStepTime);
+            const int64_t k = fixedRate ? (int64_t)std::floor(double(time) / stepLen) + 1 : simStep + 1;
+            const bool restart = simStep < 0 || gSpectrumDirty;
+            if (k > simStep || restart)
             {
-                float t;
-                float windX;
-                float windY;
-                float amp;
-                float windSpeed;
-                float pad[3];
-            } sp{};
-            sp.t = time;
-            sp.windX = windX;
-            sp.windY = windY;
-            sp.amp = amp;
-            sp.windSpeed = windSpeed;
-            sp.pad[0] = patchSize;
-            sp.pad[1] = seed;
-            vkCmdPushConstants(cmd, compSpectrumLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, 32, &sp);
-            vkCmdDispatch(cmd, (uint32_t)((FREQ_SIZE + 15) / 16), (uint32_t)((FREQ_SIZE + 15) / 16), 1);
-
-            imageBarrierGeneral(cmd, H.image, VK_IMAGE_ASPECT_COLOR_BIT,
-                                VK_ACCESS_SHADER_WRITE_BIT, VK_ACCESS_SHADER_READ_BIT,
-                                VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
-                                1, 1);
+                const double stepStart = fixedRate ? double(k - 1) * stepLen : double(time) - stepLen;
+                for (uint32_t b = 0; b < kBandCount; ++b)
+                {
+                    const int64_t n = bandInterval[b];
+                    const int64_t due = (k + bandPhase[b]) % n;
+                    BandSim &bs = bandSim[b];
+                    if (!restart && due != 0 && bs.tNewer > double(time))
+                        continue;
 
-            vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, csBuild);
-            vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, compBuildLayout, 0, 1, &dsB, 0, nullptr);
-            vkCmdDispatch(cmd, (uint32_t)(((3 * FREQ_SIZE) + 15) / 16), (uint32_t)((FREQ_SIZE + 15) / 16), 1);
+                    // the slot neither frames in flight nor this frame's blend reads
+                    uint32_t slot = (bs.newer + 1) % simSlots;
+                    if (slot == bs.older && simSlots > 2)
+                        slot = (slot + 1) % simSlots;
 
-            imageBarrierGeneral(cmd, B0.image, VK_IMAGE_ASPECT_COLOR_BIT,
-                                VK_ACCESS_SHADER_WRITE_BIT, VK_ACCESS_SHADER_READ_BIT,
-                                VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
-                                1, 1);
+                    double t = restart ? double(time) : stepStart + double(n - due) * stepLen;
+                    bs.older = restart ? slot : bs.newer;
+                    bs.tOlder = restart ? t : bs.tNewer;
+                    bs.newer = slot;
+                    bs.tNewer = t;
 
-            vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, csRows);
-            vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, compIfftLayout, 0, 1, &dsR, 0, nullptr);
-            vkCmdPushConstants(cmd, compIfftLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(ipc), &ipc);
-            vkCmdDispatch(cmd, (uint32_t)FREQ_SIZE, 3, 1);
+                    simMask |= 1u << b;
+                    bandTime[b] = float(t);
+                    bandWrite[b] = int32_t(slot * kBandCount + b);
+                }
+                // a fixed step restarted mid-step runs again next frame to give the bands a target
+                simStep = restart && fixedRate ? k - 1 : k;
+                simStepTime = time;
+            }
+        }
+        const bool simulate = simMask != 0;
 
-            imageBarrierGeneral(cmd, B1.image, VK_IMAGE_ASPECT_COLOR_BIT,
-                                VK_ACCESS_SHADER_WRITE_BIT, VK_ACCESS_SHADER_READ_BIT,
-                                VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
-                                1, 1);
+        // what the consumers read per band: the pair to blend (the newer alone once reached) and,
+        // for foam and spray, the nearer one
+        glm::mat4 bandRing(0.0f);
+        glm::ivec4 bandNearest(0);
+        for (uint32_t b = 0; b < kBandCount; ++b)
+        {
+            const BandSim &bs = bandSim[b];
+            float blend = 0.0f;
+            if (bs.older != bs.newer && bs.tNewer > bs.tOlder)
+                blend = glm::clamp(float((double(time) - bs.tOlder) / (bs.tNewer - bs.tOlder)), 0.0f, 1.0f);
+            uint32_t older = blend < 1.0f ? bs.older : bs.newer;
+            if (blend >= 1.0f)
+                blend = 0.0f;
+            bandRing[b] = glm::vec4(float(older * kBandCount + b), float(bs.newer * kBandCount + b), blend, 0.0f);
+            bandNearest[b] = int32_t((blend < 0.5f ? older : bs.newer) * kBandCount + b);
+        }
 
-            vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, csCols);
-            vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, compIfftLayout, 0, 1, &dsC, 0, nullptr);
-            vkCmdPushConstants(cmd, compIfftLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(ipc), &ipc);
-            vkCmdDispatch(cmd, (uint32_t)FREQ_SIZE, 3, 1);
+        if (simulate)
+        {
+            // the due bands in runs of consecutive layers, each one dispatch whose base workgroup z
+            // is its first band, so the kernels still see gl_WorkGroupID.z = band
+            auto dispatchBands = [&](uint32_t x, uint32_t y)
+            {
+                for (uint32_t b = 0; b < kBandCount;)
+                {
+                    if (!(simMask & (1u << b)))
+                    {
+                        ++b;
+                        continue;
+                    }
+                    uint32_t end = b;
+                    while (end < kBandCount && (simMask & (1u << end)))
+                        ++end;
+                    vkCmdDispatchBase(simCmd, 0, 0, b, x, y, end - b);
+                    b = end;
+                }
+            };
 
-            imageBarrierGeneral(cmd, B0.image, VK_IMAGE_ASPECT_COLOR_BIT,
-                                VK_ACCESS_SHADER_WRITE_BIT, VK_ACCESS_SHADER_READ_BIT,
-                                VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
-                                1, 1);
-        };
+            // FFT chain
+            float invN = 1.0f / float(gFreqSize);
+            struct alignas(8)
+            {
+                float invN;
+                float finalScale;
+            } ipc{};
+            ipc.invN = invN;
+            // rows*cols scale by 1/N^2 but the extra modes of a larger N add little energy, so rescale
+            // to keep heights independent of the resolution
+            ipc.finalScale = kFftFinalScale * float(gFreqSize * gFreqSize) / (256.0f * 256.0f);
+
+            // h0 / w cache, only when the spectrum parameters changed
+            if (gSpectrumDirty)
+            {
+                simProfiler.begin(simCmd, "spectrum init");
+
+                // earlier frames may still be reading the cache
+                imageBarrierGeneral(simCmd, texH0Cache.image, VK_IMAGE_ASPECT_COLOR_BIT,
+                                    0, VK_ACCESS_SHADER_WRITE_BIT,
+                                    VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                                    1, kBandCount);
+                imageBarrierGeneral(simCmd, texOmega.image, VK_IMAGE_ASPECT_COLOR_BIT,
+                                    0, VK_ACCESS_SHADER_WRITE_BIT,
+                                    VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                                    1, kBandCount);
+
+                // all bands in one dispatch, z = band
+                struct alignas(16)
+                {
+                    glm::vec4 bandA[kMaxBands]; // windX, windY, amp, windSpeed
+                    glm::vec4 bandB[kMaxBands]; // patchSize, seed, kMin, kMax
+                } ip{};
+                float ca = std::cos(gWindAngle);
+                float sa = std::sin(gWindAngle);
+                for (uint32_t b = 0; b < kBandCount; b++)
+                {
+                    const OceanBand &band = kOceanBands[b];
+                    glm::vec2 wind(ca * band.wind.x - sa * band.wind.y, sa * band.wind.x + ca * band.wind.y);
+                    ip.bandA[b] = glm::vec4(wind, band.amp * gSpectrumAmpScale, band.windSpeed * gWindSpeedScale);
+                    ip.bandB[b] = glm::vec4(band.patchSize, float(band.seed), band.kMin, band.kMax);
+                }
+                vkCmdBindPipeline(simCmd, VK_PIPELINE_BIND_POINT_COMPUTE, csSpectrumInit);
+                vkCmdBindDescriptorSets(simCmd, VK_PIPELINE_BIND_POINT_COMPUTE, compSpectrumInitLayout, 0, 1, &dsSpectrumInit, 0, nullptr);
+                vkCmdPushConstants(simCmd, compSpectrumInitLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(ip), &ip);
+                vkCmdDispatch(simCmd, (uint32_t)((gFreqSize + 15) / 16), (uint32_t)((gFreqSize + 15) / 16), kBandCount);
+                simProfiler.end(simCmd);
+
+                imageBarrierGeneral(simCmd, texH0Cache.image, VK_IMAGE_ASPECT_COLOR_BIT,
+                                    VK_ACCESS_SHADER_WRITE_BIT, VK_ACCESS_SHADER_READ_BIT,
+                                    VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                                    1, kBandCount);
+                imageBarrierGeneral(simCmd, texOmega.image, VK_IMAGE_ASPECT_COLOR_BIT,
+                                    VK_ACCESS_SHADER_WRITE_BIT, VK_ACCESS_SHADER_READ_BIT,
+                                    VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                                    1, kBandCount);
+                waveSigma = spectrumSigma(gWindAngle, gSpectrumAmpScale, gWindSpeedScale);
+                gSpectrumDirty = false;
+            }
 
-        // 0 swell
-        runFFTBand(dsSpectrum0, dsBuild0, dsRows0, dsCols0, texH0, texB0_0, texB1_0,
-                   0.8f, 0.2f, 0.0018f, 38.0f,
-                   PATCH_SIZE, 1337.0f);
+            // both kernel kinds share set 0 and the push constants, stockham adds the twiddles in set 1
+            auto bindIfft = [&](VkPipeline pipe, VkDescriptorSet ds)
+            {
+                bool stockham = gFftPath != FftPath::Radix2;
+                VkPipelineLayout layout = stockham ? compStockhamLayout : compIfftLayout;
+                vkCmdBindPipeline(simCmd, VK_PIPELINE_BIND_POINT_COMPUTE, pipe);
+                vkCmdBindDescriptorSets(simCmd, VK_PIPELINE_BIND_POINT_COMPUTE, layout, 0, 1, &ds, 0, nullptr);
+                if (stockham)
+                    vkCmdBindDescriptorSets(simCmd, VK_PIPELINE_BIND_POINT_COMPUTE, layout, 1, 1, &dsTwiddle, 0, nullptr);
+                vkCmdPushConstants(simCmd, layout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(ipc), &ipc);
+            };
+
+            // the cols of every path, B1 -> B0
+            auto recordCols = [&](VkPipeline pipe, VkDescriptorSet ds)
+            {
+                bindIfft(pipe, ds);
+                dispatchBands((uint32_t)gFreqSize, 4);
+            };
 
-        // 1 wind
-        runFFTBand(dsSpectrum1, dsBuild1, dsRows1, dsCols1, texH1, texB0_1, texB1_1,
-                   1.0f, 0.0f, 0.0030f, 22.0f,
-                   PATCH_SIZE, 424242.0f);
+            // every pass covers the bands due this step, gl_WorkGroupID.z = band
+            if (gFftPath == FftPath::Fused)
+            {
+                // spectrum, tiles and rows
+                simProfiler.begin(simCmd, "fused rows");
+                struct alignas(16)
+                {
+                    glm::vec4 t;
+                    glm::vec4 patchSize;
+                    float invN;
+                } fp{};
+                fp.t = bandTime;
+                fp.patchSize = bandPatch;
+                fp.invN = invN;
+                vkCmdBindPipeline(simCmd, VK_PIPELINE_BIND_POINT_COMPUTE, csFusedRows);
+                VkDescriptorSet rowSets[2] = {dsFusedRows, dsTwiddle};
+                vkCmdBindDescriptorSets(simCmd, VK_PIPELINE_BIND_POINT_COMPUTE, compFusedRowsLayout, 0, 2, rowSets, 0, nullptr);
+                vkCmdPushConstants(simCmd, compFusedRowsLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(fp), &fp);
+                dispatchBands((uint32_t)gFreqSize, 1);
+                simProfiler.end(simCmd);
+
+                imageBarrierGeneral(simCmd, texB1.image, VK_IMAGE_ASPECT_COLOR_BIT,
+                                    VK_ACCESS_SHADER_WRITE_BIT, VK_ACCESS_SHADER_READ_BIT,
+                                    VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                                    1, kBandCount);
+
+                simProfiler.begin(simCmd, "fft cols");
+                recordCols(csStockhamCols, dsCols);
+                simProfiler.end(simCmd);
+            }
+            else
+            {
+                simProfiler.begin(simCmd, "spectrum");
+                vkCmdBindPipeline(simCmd, VK_PIPELINE_BIND_POINT_COMPUTE, csSpectrum);
+                vkCmdBindDescriptorSets(simCmd, VK_PIPELINE_BIND_POINT_COMPUTE, compSpectrumLayout, 0, 1, &dsSpectrum, 0, nullptr);
+                vkCmdPushConstants(simCmd, compSpectrumLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(bandTime), &bandTime);
+                dispatchBands((uint32_t)((gFreqSize + 15) / 16), (uint32_t)((gFreqSize + 15) / 16));
+                simProfiler.end(simCmd);
+
+                imageBarrierGeneral(simCmd, texH.image, VK_IMAGE_ASPECT_COLOR_BIT,
+                                    VK_ACCESS_SHADER_WRITE_BIT, VK_ACCESS_SHADER_READ_BIT,
+                                    VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                                    1, kBandCount);
+
+                simProfiler.begin(simCmd, "build");
+                vkCmdBindPipeline(simCmd, VK_PIPELINE_BIND_POINT_COMPUTE, csBuild);
+                vkCmdBindDescriptorSets(simCmd, VK_PIPELINE_BIND_POINT_COMPUTE, compBuildLayout, 0, 1, &dsBuild, 0, nullptr);
+                vkCmdPushConstants(simCmd, compBuildLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(bandPatch), &bandPatch);
+                dispatchBands((uint32_t)((gFreqSize + 15) / 16), (uint32_t)((gFreqSize + 15) / 16));
+                simProfiler.end(simCmd);
+
+                imageBarrierGeneral(simCmd, texB0.image, VK_IMAGE_ASPECT_COLOR_BIT,
+                                    VK_ACCESS_SHADER_WRITE_BIT, VK_ACCESS_SHADER_READ_BIT,
+                                    VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                                    1, kBandCount);
+
+                simProfiler.begin(simCmd, "fft rows");
+                bindIfft(gFftPath == FftPath::Radix2 ? csRows : csStockhamRows, dsRows);
+                dispatchBands((uint32_t)gFreqSize, 4);
+                simProfiler.end(simCmd);
+
+                imageBarrierGeneral(simCmd, texB1.image, VK_IMAGE_ASPECT_COLOR_BIT,
+                                    VK_ACCESS_SHADER_WRITE_BIT, VK_ACCESS_SHADER_READ_BIT,
+                                    VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                                    1, kBandCount);
+
+                simProfiler.begin(simCmd, "fft cols");
+                recordCols(gFftPath == FftPath::Radix2 ? csCols : csStockhamCols, dsCols);
+                simProfiler.end(simCmd);
+            }
 
-        // combine
-        vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, csCombine);
-        vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, compCombineLayout, 0, 1, &dsCombine, 0, nullptr);
-        struct alignas(16)
-        {
-            float windDisp;
-            float pad[3];
-        } cpc{};
-        cpc.windDisp = 0.35f;
-        vkCmdPushConstants(cmd, compCombineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, 16, &cpc);
-        vkCmdDispatch(cmd, (uint32_t)(((3 * FREQ_SIZE) + 15) / 16), (uint32_t)((FREQ_SIZE + 15) / 16), 1);
-
-        // make combination visible
-        imageBarrierGeneral(cmd, texBCombined.image, VK_IMAGE_ASPECT_COLOR_BIT,
-                            VK_ACCESS_SHADER_WRITE_BIT, VK_ACCESS_SHADER_READ_BIT,
-                            VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
-                            1, 1);
-
-        // wind visibility
-        imageBarrierGeneral(cmd, texB0_1.image, VK_IMAGE_ASPECT_COLOR_BIT,
-                            VK_ACCESS_SHADER_WRITE_BIT, VK_ACCESS_SHADER_READ_BIT,
-                            VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
-                            VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
-                            1, 1);
+            imageBarrierGeneral(simCmd, texB0.image, VK_IMAGE_ASPECT_COLOR_BIT,
+                                VK_ACCESS_SHADER_WRITE_BIT, VK_ACCESS_SHADER_READ_BIT,
+                                VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                                1, kBandCount);
+
+            // field tiles -> one RGBA displacement texel, so consumers filter h / dx / dz in one fetch,
+            // and the slopes / Jacobian terms every consumer shares
+            simProfiler.begin(simCmd, "disp pack");
+            vkCmdBindPipeline(simCmd, VK_PIPELINE_BIND_POINT_COMPUTE, csDispPack);
+            vkCmdBindDescriptorSets(simCmd, VK_PIPELINE_BIND_POINT_COMPUTE, compDispPackLayout, 0, 1, &dsDispPack, 0, nullptr);
+            vkCmdPushConstants(simCmd, compDispPackLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(bandWrite), &bandWrite);
+            dispatchBands((uint32_t)((gFreqSize + 15) / 16), (uint32_t)((gFreqSize + 15) / 16));
+            simProfiler.end(simCmd);
+
+            // mip chains, each level from the one above
+            simProfiler.begin(simCmd, "disp mips");
+            vkCmdBindPipeline(simCmd, VK_PIPELINE_BIND_POINT_COMPUTE, csDispMip);
+            vkCmdPushConstants(simCmd, compDispMipLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(bandWrite), &bandWrite);
+            for (uint32_t m = 1; m < dispMips; ++m)
+            {
+                for (VkImage img : {texDisp.image, texDeriv.image})
+                    imageBarrierGeneral(simCmd, img, VK_IMAGE_ASPECT_COLOR_BIT,
+                                        VK_ACCESS_SHADER_WRITE_BIT, VK_ACCESS_SHADER_READ_BIT,
+                                        VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                                        dispMips, dispLayers);
+                uint32_t size = fftN >> m;
+                for (VkDescriptorSet ds : {dsDispMip[m], dsDerivMip[m]})
+                {
+                    vkCmdBindDescriptorSets(simCmd, VK_PIPELINE_BIND_POINT_COMPUTE, compDispMipLayout, 0, 1, &ds, 0, nullptr);
+                    dispatchBands((size + 7) / 8, (size + 7) / 8);
+                }
+            }
+            simProfiler.end(simCmd);
 
-        uint32_t foamRead = foamParity;
-        uint32_t foamWrite = 1u - foamRead;
+            // displacement + derivatives visible to foam / spray
+            for (VkImage img : {texDisp.image, texDeriv.image})
+                imageBarrierGeneral(simCmd, img, VK_IMAGE_ASPECT_COLOR_BIT,
+                                    VK_ACCESS_SHADER_WRITE_BIT, VK_ACCESS_SHADER_READ_BIT,
+                                    VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                                    dispMips, dispLayers);
 
-        imageBarrierGeneral(cmd, texBCombined.image, VK_IMAGE_ASPECT_COLOR_BIT,
-                            VK_ACCESS_SHADER_WRITE_BIT, VK_ACCESS_SHADER_READ_BIT,
-                            VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
-                            1, 1);
+            // --fft-validate: same pack at fp32 from the same cols, then max |error| per band
+            if (gFftValidate)
+            {
+                simProfiler.begin(simCmd, "fft validate");
+                imageBarrierGeneral(simCmd, texDispRef.image, VK_IMAGE_ASPECT_COLOR_BIT,
+                                    VK_ACCESS_SHADER_READ_BIT, VK_ACCESS_SHADER_WRITE_BIT,
+                                    VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                                    1, kBandCount);
+                vkCmdBindPipeline(simCmd, VK_PIPELINE_BIND_POINT_COMPUTE, csDispPackRef);
+                vkCmdBindDescriptorSets(simCmd, VK_PIPELINE_BIND_POINT_COMPUTE, compDispPackLayout, 0, 1, &dsDispPackRef, 0, nullptr);
+                const glm::ivec4 refLayers(0, 1, 2, 3);
+                vkCmdPushConstants(simCmd, compDispPackLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(refLayers), &refLayers);
+                dispatchBands((uint32_t)((gFreqSize + 15) / 16), (uint32_t)((gFreqSize + 15) / 16));
+                imageBarrierGeneral(simCmd, texDispRef.image, VK_IMAGE_ASPECT_COLOR_BIT,
+                                    VK_ACCESS_SHADER_WRITE_BIT, VK_ACCESS_SHADER_READ_BIT,
+                                    VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                                    1, kBandCount);
+
+                struct alignas(16)
+                {
+                    uint32_t slot;
+                    uint32_t pad[3];
+                    glm::ivec4 layer;
+                } vpc{ctx.frameIndex, {}, bandWrite};
+                vkCmdBindPipeline(simCmd, VK_PIPELINE_BIND_POINT_COMPUTE, csValidate);
+                vkCmdBindDescriptorSets(simCmd, VK_PIPELINE_BIND_POINT_COMPUTE, compValidateLayout, 0, 1, &dsValidate, 0, nullptr);
+                vkCmdPushConstants(simCmd, compValidateLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(vpc), &vpc);
+                dispatchBands((uint32_t)((gFreqSize + 15) / 16), (uint32_t)((gFreqSize + 15) / 16));
+                simProfiler.end(simCmd);
+            }
+        }
 
-        vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, csFoam);
-        vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, compFoamLayout, 0, 1, &dsFoam[foamRead], 0, nullptr);
+        simProfiler.begin(simCmd, "foam");
+        vkCmdBindPipeline(simCmd, VK_PIPELINE_BIND_POINT_COMPUTE, csFoam);
+        vkCmdBindDescriptorSets(simCmd, VK_PIPELINE_BIND_POINT_COMPUTE, compFoamLayout, 0, 1, &dsFoam[foamRead], 0, nullptr);
 
         struct alignas(16)
         {
@@ -3164,6 +4631,8 @@ int main(int argc, char **argv)
             float fold1;
             float streak;
             float spray;
+            glm::vec4 bandWeight;
+            glm::ivec4 layer;
         } fpc{};
         fpc.dt = std::min(deltaTime, 0.050f);
         fpc.patchSize = PATCH_SIZE;
@@ -3177,24 +4646,43 @@ int main(int argc, char **argv)
         fpc.fold1 = 0.60f;
         fpc.streak = 1.00f;
         fpc.spray = 0.0f;
+        fpc.bandWeight = foamBandWeight;
+        fpc.layer = bandNearest;
 
-        vkCmdPushConstants(cmd, compFoamLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, 48, &fpc);
-        vkCmdDispatch(cmd, (uint32_t)((FREQ_SIZE + 15) / 16), (uint32_t)((FREQ_SIZE + 15) / 16), 1);
+        vkCmdPushConstants(simCmd, compFoamLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(fpc), &fpc);
+        vkCmdDispatch(simCmd, (uint32_t)((gFreqSize + 15) / 16), (uint32_t)((gFreqSize + 15) / 16), 1);
+        simProfiler.end(simCmd);
 
-        imageBarrierGeneral(cmd, foamImg[foamWrite].image, VK_IMAGE_ASPECT_COLOR_BIT,
-                            VK_ACCESS_SHADER_WRITE_BIT, VK_ACCESS_SHADER_READ_BIT,
-                            VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
-                            VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
-                            1, 1);
+        if (ctx.asyncCompute)
+        {
+            // the graphics submit waits on the timeline at compute / vertex / fragment, which makes
+            // foam, displacement and derivatives visible there and in the tessellation stages,
+            // which run after the vertex wait
+            ctx.submitCompute();
+        }
+        else
+        {
+            imageBarrierGeneral(cmd, foamImg[foamWrite].image, VK_IMAGE_ASPECT_COLOR_BIT,
+                                VK_ACCESS_SHADER_WRITE_BIT, VK_ACCESS_SHADER_READ_BIT,
+                                VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                                VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+                                1, 1);
 
-        // make texB0 visible
-        imageBarrierGeneral(cmd, texBCombined.image, VK_IMAGE_ASPECT_COLOR_BIT,
-                            VK_ACCESS_SHADER_WRITE_BIT, VK_ACCESS_SHADER_READ_BIT,
-                            VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
-                            VK_PIPELINE_STAGE_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
-                            1, 1);
+            // make the displacement + derivatives visible to the vertex, fragment and (--tessellation,
+            // water.tesc / water.tese sample both) tessellation stages
+            VkPipelineStageFlags dispReaders = VK_PIPELINE_STAGE_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+            if (ctx.tessellation)
+                dispReaders |= VK_PIPELINE_STAGE_TESSELLATION_CONTROL_SHADER_BIT | VK_PIPELINE_STAGE_TESSELLATION_EVALUATION_SHADER_BIT;
+            for (VkImage img : {texDisp.image, texDeriv.image})
+                imageBarrierGeneral(cmd, img, VK_IMAGE_ASPECT_COLOR_BIT,
+                                    VK_ACCESS_SHADER_WRITE_BIT, VK_ACCESS_SHADER_READ_BIT,
+                                    VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                                    dispReaders,
+                                    dispMips, dispLayers);
+        }
 
         // update
+        profiler.begin(cmd, "spray update");
         vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, csSprayUpdate);
         vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, compSprayUpdateLayout, 0, 1, &dsSpray, 0, nullptr);
         struct alignas(16)
@@ -3209,7 +4697,9 @@ int main(int argc, char **argv)
         upc.gravity = -9.8f;
         vkCmdPushConstants(cmd, compSprayUpdateLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, 16, &upc);
         vkCmdDispatch(cmd, (MAX_PARTICLES + 255) / 256, 1, 1);
+        profiler.end(cmd);
 
+        profiler.begin(cmd, "spray spawn");
         vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, csSpraySpawn);
         vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, compSpraySpawnLayout, 0, 1, &dsSpray, 0, nullptr);
         struct alignas(16)
@@ -3230,6 +4720,8 @@ int main(int argc, char **argv)
             float vUp;
             float vSide;
             float pad;
+            glm::vec4 bandWeight;
+            glm::ivec4 layer;
         } spc{};
         spc.dt = std::min(deltaTime, 0.050f);
         spc.patchSize = PATCH_SIZE;
@@ -3246,8 +4738,11 @@ int main(int argc, char **argv)
         spc.baseLife = 1.15f;
         spc.vUp = 8.5f;
         spc.vSide = 4.0f;
-        vkCmdPushConstants(cmd, compSpraySpawnLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, 64, &spc);
+        spc.layer = bandNearest;
+        spc.bandWeight = foamBandWeight;
+        vkCmdPushConstants(cmd, compSpraySpawnLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(spc), &spc);
         vkCmdDispatch(cmd, (128 + 15) / 16, (128 + 15) / 16, 1);
+        profiler.end(cmd);
 
         // make spray buffer visible to vertex shader
         bufferBarrier(cmd, sprayBuf.buffer,
@@ -3293,9 +4788,156 @@ int main(int argc, char **argv)
         // boat parameters for water.frag
         ubo.boat0 = glm::vec4(gBoatPos.x, gBoatPos.y, gBoatYaw, 0.0f);
         ubo.boat1 = glm::vec4(std::abs(gBoatSpeed), gBoatLen, gBoatWid, gBoatDraft);
+        ubo.bandPatch = bandPatch;
+        ubo.bandDisp = bandDisp;
+        ubo.bandNormal = bandNormal;
+        ubo.bandFade = bandFade;
+        ubo.bandRing = bandRing;
 
         std::memcpy(uboMap[ctx.frameIndex], &ubo, sizeof(ubo));
 
+        // water: select the quadtree nodes of every tile by distance and cull them against this
+        // frame's frustum, either on the GPU into the indirect draw or (--cpu-tiles) on the CPU into
+        // this frame's range of the mapped node ring, then hand the draw and nodes to the main pass.
+        // The projected grid needs neither
+        uint32_t waterNodeBase = 0;  // first node of this frame
+        uint32_t waterNodeCount = 0; // --cpu-tiles: visible nodes
+        if (!gProjectedGrid)
+        {
+            // frustum planes of proj * view (rows 3 +- 0, 1, 2), in the render space the tiles
+            // are placed in. Near is taken as -w <= z, which also covers the 0..1 depth range
+            struct
+            {
+                glm::vec4 planes[6];
+                glm::vec4 camera;
+                glm::vec4 bounds;
+            } cpc{};
+            for (int r = 0; r < 3; ++r)
+            {
+                glm::vec4 row(currVP[0][r], currVP[1][r], currVP[2][r], currVP[3][r]);
+                glm::vec4 w(currVP[0][3], currVP[1][3], currVP[2][3], currVP[3][3]);
+                cpc.planes[r * 2 + 0] = w + row;
+                cpc.planes[r * 2 + 1] = w - row;
+            }
+
+            // range of level 0: where its cells shrink to gLodPixels on screen. At least 8 leaf
+            // nodes, so neighbours are never more than one level apart and the coarser one has not
+            // started morphing along their seam (2 sqrt(2) nodes / (2 kWaterMorphStart - 1))
+            const float leafSize = PATCH_SIZE / float(1 << (kWaterLevels - 1));
+            const float pixelAngle = 2.0f * std::tan(glm::radians(fov) * 0.5f) / float(ctx.swapExtent.height);
+            const float lodPixels = ctx.tessellation ? gLodPixels * kTessBaseScale : gLodPixels;
+            const float range0 = std::max(leafSize / float(kWaterNodeGrid) / (pixelAngle * lodPixels), 8.0f * leafSize);
+            cpc.camera = glm::vec4(cameraPos, range0);
+
+            // the displaced surface stays within kWaveSigmas of the live spectrum's deviation per unit
+            // of heightScale / choppy, plus the swell; the skirts of the outer edge hang kWaterSkirtDepth below
+            const float waveBound = kWaveSigmas * waveSigma;
+            const float top = gHeightScale * waveBound + gSwellAmp;
+            const int radius = infiniteOcean ? oceanRadius : 0;
+            cpc.bounds = glm::vec4(gChoppy * waveBound, top, PATCH_SIZE, float(radius));
+
+            if (gCpuTiles)
+            {
+                // same selection and tests as water_cull.comp, walked top down. The frame fence of
+                // this slot was waited on, so its range of the ring is no longer read
+                auto cullStart = std::chrono::steady_clock::now();
+                waterNodeBase = ctx.frameIndex * waterNodeCapacity;
+                glm::vec4 *nodes = waterNodeRingMap + waterNodeBase;
+
+                auto nodeDist = [&](glm::vec2 c, float size) -> float
+                {
+                    glm::vec2 d = glm::max(glm::abs(glm::vec2(cameraPos.x, cameraPos.z) - c) - 0.5f * size, 0.0f);
+                    return glm::length(glm::vec3(d.x, cameraPos.y, d.y));
+                };
+                auto outsideOcean = [&](glm::ivec2 t) -> bool
+                { return waterOutsideOcean(t, radius); };
+                // the skirt only deepens the box of nodes along the outer edge of the ocean
+                auto inFrustum = [&](glm::ivec2 tile, glm::vec2 c, float size) -> bool
+                {
+                    glm::vec2 lo = glm::vec2(tile) * PATCH_SIZE - 0.5f * PATCH_SIZE;
+                    glm::vec2 hi = lo + PATCH_SIZE;
+                    bool edge = (c.x - 0.5f * size <= lo.x && outsideOcean(tile - glm::ivec2(1, 0))) ||
+                                (c.x + 0.5f * size >= hi.x && outsideOcean(tile + glm::ivec2(1, 0))) ||
+                                (c.y - 0.5f * size <= lo.y && outsideOcean(tile - glm::ivec2(0, 1))) ||
+                                (c.y + 0.5f * size >= hi.y && outsideOcean(tile + glm::ivec2(0, 1)));
+                    const float yMin = -top - (edge ? kWaterSkirtDepth : 0.0f);
+                    glm::vec3 center(c.x, 0.5f * (yMin + top), c.y);
+                    glm::vec3 extent(0.5f * size + cpc.bounds.x, 0.5f * (top - yMin), 0.5f * size + cpc.bounds.x);
+                    for (int p = 0; p < 6; ++p)
+                    {
+                        glm::vec3 n(cpc.planes[p]);
+                        if (glm::dot(n, center) + glm::dot(glm::abs(n), extent) + cpc.planes[p].w < 0.0f)
+                            return false;
+                    }
+                    return true;
+                };
+                // a node inside the range of the level below is split, otherwise drawn whole
+                auto visit = [&](auto &self, glm::ivec2 tile, glm::vec2 c, int level) -> void
+                {
+                    float size = leafSize * float(1 << level);
+                    if (!inFrustum(tile, c, size))
+                        return;
+                    if (level > 0 && nodeDist(c, size) < waterLevelRange(range0, level - 1))
+                    {
+                        for (int q = 0; q < 4; ++q)
+                        {
+                            glm::vec2 o(float(q & 1) - 0.5f, float(q >> 1) - 0.5f);
+                            self(self, tile, c + o * (0.5f * size), level - 1);
+                        }
+                        return;
+                    }
+                    nodes[waterNodeCount++] = glm::vec4(c, size, waterMorphEnd(range0, level));
+                };
+
+                for (int tz = -radius; tz <= radius; ++tz)
+                {
+                    for (int tx = -radius; tx <= radius; ++tx)
+                    {
+                        if (!outsideOcean(glm::ivec2(tx, tz)))
+                            visit(visit, glm::ivec2(tx, tz), glm::vec2(float(tx), float(tz)) * PATCH_SIZE, kWaterLevels - 1);
+                    }
+                }
+
+                double cullMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - cullStart).count();
+                cpuCullMsSum += cullMs;
+                cpuCullMsMax = std::max(cpuCullMsMax, cullMs);
+                cpuCullFrames++;
+            }
+            else
+            {
+                profiler.begin(cmd, "water cull");
+                VkDrawIndexedIndirectCommand draw{};
+                draw.indexCount = meshNode.indexCount;
+
+                // the previous frame's draw may still be reading both
+                bufferBarrier(cmd, waterDrawBuf.buffer,
+                              VK_ACCESS_INDIRECT_COMMAND_READ_BIT, VK_ACCESS_TRANSFER_WRITE_BIT,
+                              VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT);
+                vkCmdUpdateBuffer(cmd, waterDrawBuf.buffer, 0, sizeof(draw), &draw);
+                bufferBarrier(cmd, waterDrawBuf.buffer,
+                              VK_ACCESS_TRANSFER_WRITE_BIT, VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT,
+                              VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT);
+                bufferBarrier(cmd, waterNodeBuf.buffer,
+                              VK_ACCESS_SHADER_READ_BIT, VK_ACCESS_SHADER_WRITE_BIT,
+                              VK_PIPELINE_STAGE_VERTEX_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT);
+
+                // one invocation per tile and node of its quadtree
+                uint32_t side = uint32_t(2 * radius + 1);
+                vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, csWaterCull);
+                vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, compWaterCullLayout, 0, 1, &dsWaterCull, 0, nullptr);
+                vkCmdPushConstants(cmd, compWaterCullLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(cpc), &cpc);
+                vkCmdDispatch(cmd, (side * side + 63) / 64, kWaterNodesPerTile, 1);
+
+                bufferBarrier(cmd, waterDrawBuf.buffer,
+                              VK_ACCESS_SHADER_WRITE_BIT, VK_ACCESS_INDIRECT_COMMAND_READ_BIT,
+                              VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT);
+                bufferBarrier(cmd, waterNodeBuf.buffer,
+                              VK_ACCESS_SHADER_WRITE_BIT, VK_ACCESS_SHADER_READ_BIT,
+                              VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_VERTEX_SHADER_BIT);
+                profiler.end(cmd);
+            }
+        }
+
         // offscreen pass for water.frag
         if (sceneFramebuffer && hdrImg.image)
         {
@@ -3310,6 +4952,7 @@ int main(int argc, char **argv)
             sbi.clearValueCount = 2;
             sbi.pClearValues = sclr;
 
+            profiler.begin(cmd, "scene sky");
             vkCmdBeginRenderPass(cmd, &sbi, VK_SUBPASS_CONTENTS_INLINE);
 
             VkViewport svp{};
@@ -3330,6 +4973,7 @@ int main(int argc, char **argv)
             vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, skyLayout, 0, 2, skySets, 0, nullptr);
             vkCmdDraw(cmd, 36, 1, 0, 0);
             vkCmdEndRenderPass(cmd);
+            profiler.end(cmd);
         }
 
         // main HDR pass
@@ -3344,6 +4988,8 @@ int main(int argc, char **argv)
         mbi.clearValueCount = 2;
         mbi.pClearValues = mclr;
 
+        profiler.begin(cmd, "main hdr");
+        profiler.beginStats(cmd, "main hdr");
         vkCmdBeginRenderPass(cmd, &mbi, VK_SUBPASS_CONTENTS_INLINE);
 
         VkViewport vp{};
@@ -3359,73 +5005,45 @@ int main(int argc, char **argv)
         vkCmdSetViewport(cmd, 0, 1, &vp);
         vkCmdSetScissor(cmd, 0, 1, &sc);
 
-        if (hdrImg.image)
+        // the water and the duck, drawn twice with --depth-prepass: depth only, then shaded
+        auto drawWater = [&](VkPipeline pipe)
         {
-            vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, skyMainPipe);
-            VkDescriptorSet skySets[2] = {uboSet[ctx.frameIndex], texSet[foamWrite]};
-            vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, skyLayout, 0, 2, skySets, 0, nullptr);
-            vkCmdDraw(cmd, 36, 1, 0, 0);
-        }
+            vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, pipe);
 
-        VkPipeline useWater = (wireframe && waterLine) ? waterLine : waterFill;
-        vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, useWater);
+            VkDescriptorSet sets[2] = {uboSet[ctx.frameIndex], texSet[foamWrite]};
+            vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, waterLayout, 0, 2, sets, 0, nullptr);
 
-        VkDescriptorSet sets[2] = {uboSet[ctx.frameIndex], texSet[foamWrite]};
-        vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, waterLayout, 0, 2, sets, 0, nullptr);
-
-        auto bindMesh = [&](const WaterMesh &m)
-        {
-            VkBuffer vb = m.vbo.buffer;
-            VkDeviceSize off = 0;
-            vkCmdBindVertexBuffers(cmd, 0, 1, &vb, &off);
-            vkCmdBindIndexBuffer(cmd, m.ibo.buffer, 0, VK_INDEX_TYPE_UINT32);
-        };
-
-        const WaterMesh *curMesh = nullptr;
-
-        auto drawTile = [&](const glm::vec2 &tileOrigin, const WaterMesh &m)
-        {
-            if (curMesh != &m)
-            {
-                bindMesh(m);
-                curMesh = &m;
-            }
-            WaterPush pc{};
-            pc.worldOffset = tileOrigin;
-            vkCmdPushConstants(cmd, waterLayout, VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT, 0, sizeof(WaterPush), &pc);
-            vkCmdDrawIndexed(cmd, m.indexCount, 1, 0, 0, 0);
-        };
-
-        if (!infiniteOcean)
-        {
-            drawTile(worldOrigin, meshHi);
-        }
-        else
-        {
-            float rr = float(oceanRadius) + 0.5f;
-            float rr2 = rr * rr;
-
-            for (int tz = -oceanRadius; tz <= oceanRadius; ++tz)
+            // the nodes the cull kept, one instanced draw of the node mesh, instance = node; or the
+            // whole screen grid
+            if (gProjectedGrid || !gCpuTiles || waterNodeCount > 0)
             {
-                for (int tx = -oceanRadius; tx <= oceanRadius; ++tx)
+                const WaterMesh &m = gProjectedGrid ? meshProjected : meshNode;
+                if (!gVertexless)
                 {
-                    if (float(tx * tx + tz * tz) > rr2)
-                        continue;
-
-                    int ring = std::max(std::abs(tx), std::abs(tz));
-                    const WaterMesh *m = (ring <= lod0Radius) ? &meshHi : (ring <= lod1Radius) ? &meshMid
-                                                                                               : &meshLo;
-
-                    glm::vec2 tileOrigin = worldOrigin + glm::vec2((float)tx * PATCH_SIZE, (float)tz * PATCH_SIZE);
-                    drawTile(tileOrigin, *m);
+                    VkBuffer vb = m.vbo.buffer;
+                    VkDeviceSize off = 0;
+                    vkCmdBindVertexBuffers(cmd, 0, 1, &vb, &off);
                 }
+                vkCmdBindIndexBuffer(cmd, m.ibo.buffer, 0, m.indexType);
+
+                WaterPush pc{};
+                pc.worldOffset = worldOrigin;
+                pc.nodeBase = waterNodeBase;
+                pc.oceanRadius = infiniteOcean ? oceanRadius : 0;
+                vkCmdPushConstants(cmd, waterLayout, VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT, 0, sizeof(WaterPush), &pc);
+                if (gProjectedGrid)
+                    vkCmdDrawIndexed(cmd, m.indexCount, 1, 0, 0, 0);
+                else if (gCpuTiles)
+                    vkCmdDrawIndexed(cmd, meshNode.indexCount, waterNodeCount, 0, 0, 0);
+                else
+                    vkCmdDrawIndexedIndirect(cmd, waterDrawBuf.buffer, 0, 1, sizeof(VkDrawIndexedIndirectCommand));
             }
-        }
+        };
 
         // boat float on waves
-        if (gBoatEnabled && boatPipe)
+        auto drawDuck = [&](VkPipeline pipe)
         {
-            vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, boatPipe);
+            vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, pipe);
             VkDescriptorSet bSets[2] = {uboSet[ctx.frameIndex], texSet[foamWrite]};
             vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, boatLayout, 0, 2, bSets, 0, nullptr);
 
@@ -3438,14 +5056,43 @@ int main(int argc, char **argv)
             vkCmdBindVertexBuffers(cmd, 0, 1, &duckMesh.vbo.buffer, &zOff);
             vkCmdBindIndexBuffer(cmd, duckMesh.ibo.buffer, 0, VK_INDEX_TYPE_UINT32);
             vkCmdDrawIndexed(cmd, duckMesh.indexCount, 1, 0, 0, 0);
+        };
+
+        VkPipeline useWater = (wireframe && waterLine) ? waterLine : waterFill;
+        if (gProjectedGrid)
+            useWater = (wireframe && waterProjLine) ? waterProjLine : waterProjFill;
+        const bool duckVisible = gBoatEnabled && boatPipe;
+
+        // depth pre-pass; the wireframe pipelines keep their own LESS test and skip it. The sky
+        // below is rejected early wherever they cover it too
+        if (gDepthPrepass)
+        {
+            if (useWater == waterFill || useWater == waterProjFill)
+                drawWater(gProjectedGrid ? waterProjDepth : waterDepth);
+            if (duckVisible)
+                drawDuck(boatDepth);
         }
 
+        if (hdrImg.image)
+        {
+            vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, skyMainPipe);
+            VkDescriptorSet skySets[2] = {uboSet[ctx.frameIndex], texSet[foamWrite]};
+            vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, skyLayout, 0, 2, skySets, 0, nullptr);
+            vkCmdDraw(cmd, 36, 1, 0, 0);
+        }
+
+        drawWater(useWater);
+        if (duckVisible)
+            drawDuck(boatPipe);
+
         vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, sprayPipe);
         VkDescriptorSet sprSets[2] = {uboSet[ctx.frameIndex], spraySet};
         vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, sprayLayout, 0, 2, sprSets, 0, nullptr);
         vkCmdDraw(cmd, 6, MAX_PARTICLES, 0, 0);
 
         vkCmdEndRenderPass(cmd);
+        profiler.endStats(cmd);
+        profiler.end(cmd);
 
         uint32_t taaRead = taaParity;
         uint32_t taaWrite = 1u - taaRead;
@@ -3458,6 +5105,7 @@ int main(int argc, char **argv)
         tbi.renderArea.extent = ctx.swapExtent;
         tbi.clearValueCount = 1;
         tbi.pClearValues = &tclr;
+        profiler.begin(cmd, "taa");
         vkCmdBeginRenderPass(cmd, &tbi, VK_SUBPASS_CONTENTS_INLINE);
 
         vkCmdSetViewport(cmd, 0, 1, &vp);
@@ -3467,6 +5115,7 @@ int main(int argc, char **argv)
         vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, taaLayout, 0, 1, &taaDS, 0, nullptr);
         vkCmdDraw(cmd, 3, 1, 0, 0);
         vkCmdEndRenderPass(cmd);
+        profiler.end(cmd);
 
         VkClearValue clears[2]{};
         clears[0].color = {{0.0f, 0.0f, 0.0f, 1.0f}};
@@ -3478,6 +5127,7 @@ int main(int argc, char **argv)
         rbi.renderArea.extent = ctx.swapExtent;
         rbi.clearValueCount = 2;
         rbi.pClearValues = clears;
+        profiler.begin(cmd, "tonemap");
         vkCmdBeginRenderPass(cmd, &rbi, VK_SUBPASS_CONTENTS_INLINE);
 
         vkCmdSetViewport(cmd, 0, 1, &vp);
@@ -3490,10 +5140,14 @@ int main(int argc, char **argv)
         vkCmdDraw(cmd, 3, 1, 0, 0);
 
         vkCmdEndRenderPass(cmd);
+        profiler.end(cmd); // tonemap
+        profiler.end(cmd); // frame
 
         taaParity = taaWrite;
 
         ctx.endFrame(imageIndex);
+        lastImageIndex = imageIndex;
+        frameCount++;
         foamParity = foamWrite;
         prevVP = currVP;
 
@@ -3501,20 +5155,83 @@ int main(int argc, char **argv)
         if (dbgTimer > 1.0f)
         {
             dbgTimer = 0.0f;
+            if (gProfilePrint)
+                printTimings();
+            if (gFftValidate)
+            {
+                printFftValidation();
+                for (uint32_t b = 0; b < kMaxBands; ++b)
+                    fftMaxErr[b] = fftMaxRef[b] = 0.0f;
+            }
         }
     }
 
     ctx.waitIdle();
 
+    {
+        double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - runStart).count();
+        if (frameCount > 0 && secs > 0.0)
+        {
+            std::cout << "Rendered " << frameCount << " frames (" << ctx.swapExtent.width << "x" << ctx.swapExtent.height
+                      << ") in " << secs << " s: " << (secs * 1000.0 / frameCount) << " ms/frame, "
+                      << (frameCount / secs) << " fps\n";
+        }
+    }
+
+    if (gProfilePrint || !gProfileCsvPath.empty())
+        printTimings();
+
+    if (gFftValidate)
+    {
+        // the last frames in flight have finished
+        for (uint32_t i = 0; i < VkContext::kMaxFrames; ++i)
+        {
+            if (!validatePending[i])
+                continue;
+            for (uint32_t b = 0; b < kBandCount; ++b)
+            {
+                float err = 0.0f, ref = 0.0f;
+                std::memcpy(&err, &validateMap[i * 8 + b], sizeof(float));
+                std::memcpy(&ref, &validateMap[i * 8 + 4 + b], sizeof(float));
+                fftMaxErr[b] = std::max(fftMaxErr[b], err);
+                fftMaxRef[b] = std::max(fftMaxRef[b], ref);
+            }
+        }
+        printFftValidation();
+    }
+
+    if (gHeadless && !gOutputPath.empty() && frameCount > 0)
+    {
+        try
+        {
+            writePPM(gOutputPath, ctx.swapExtent.width, ctx.swapExtent.height, ctx.readbackImage(lastImageIndex));
+            std::cout << "Wrote " << gOutputPath << "\n";
+        }
+        catch (const std::exception &e)
+        {
+            std::cerr << "Output error: " << e.what() << "\n";
+        }
+    }
+
     // clean
     if (waterFill)
         vkDestroyPipeline(ctx.device, waterFill, nullptr);
     if (waterLine)
         vkDestroyPipeline(ctx.device, waterLine, nullptr);
+    if (waterProjFill)
+        vkDestroyPipeline(ctx.device, waterProjFill, nullptr);
+    if (waterProjLine)
+        vkDestroyPipeline(ctx.device, waterProjLine, nullptr);
     if (skyMainPipe)
         vkDestroyPipeline(ctx.device, skyMainPipe, nullptr);
     if (boatPipe)
         vkDestroyPipeline(ctx.device, boatPipe, nullptr);
+    if (waterDepth)
+        vkDestroyPipeline(ctx.device, waterDepth, nullptr);
+    if (waterProjDepth)
+        vkDestroyPipeline(ctx.device, waterProjDepth, nullptr);
+    if (boatDepth)
+        vkDestroyPipeline(ctx.device, boatDepth, nullptr);
     if (sprayPipe)
         vkDestroyPipeline(ctx.device, sprayPipe, nullptr);
     if (taaPipe)
@@ -3523,29 +5240,43 @@ int main(int argc, char **argv)
         vkDestroyPipeline(ctx.device, tonemapPipe, nullptr);
     if (sceneSkyPipe)
         vkDestroyPipeline(ctx.device, sceneSkyPipe, nullptr);
+    vkDestroyPipeline(ctx.device, csSpectrumInit, nullptr);
     vkDestroyPipeline(ctx.device, csSpectrum, nullptr);
     vkDestroyPipeline(ctx.device, csBuild, nullptr);
     vkDestroyPipeline(ctx.device, csRows, nullptr);
     vkDestroyPipeline(ctx.device, csCols, nullptr);
-    vkDestroyPipeline(ctx.device, csCombine, nullptr);
+    vkDestroyPipeline(ctx.device, csStockhamRows, nullptr);
+    vkDestroyPipeline(ctx.device, csStockhamCols, nullptr);
+    vkDestroyPipeline(ctx.device, csFusedRows, nullptr);
+    vkDestroyPipeline(ctx.device, csDispPack, nullptr);
+    vkDestroyPipeline(ctx.device, csDispMip, nullptr);
+    vkDestroyPipeline(ctx.device, csDispPackRef, nullptr);
+    vkDestroyPipeline(ctx.device, csValidate, nullptr);
     vkDestroyPipeline(ctx.device, csFoam, nullptr);
     if (csSprayUpdate)
         vkDestroyPipeline(ctx.device, csSprayUpdate, nullptr);
     if (csSpraySpawn)
         vkDestroyPipeline(ctx.device, csSpraySpawn, nullptr);
+    vkDestroyPipeline(ctx.device, csWaterCull, nullptr);
 
     vkDestroyPipelineLayout(ctx.device, waterLayout, nullptr);
     vkDestroyPipelineLayout(ctx.device, skyLayout, nullptr);
     vkDestroyPipelineLayout(ctx.device, boatLayout, nullptr);
+    vkDestroyPipelineLayout(ctx.device, compSpectrumInitLayout, nullptr);
     vkDestroyPipelineLayout(ctx.device, compSpectrumLayout, nullptr);
     vkDestroyPipelineLayout(ctx.device, compBuildLayout, nullptr);
     vkDestroyPipelineLayout(ctx.device, compIfftLayout, nullptr);
-    vkDestroyPipelineLayout(ctx.device, compCombineLayout, nullptr);
+    vkDestroyPipelineLayout(ctx.device, compStockhamLayout, nullptr);
+    vkDestroyPipelineLayout(ctx.device, compFusedRowsLayout, nullptr);
     vkDestroyPipelineLayout(ctx.device, compFoamLayout, nullptr);
+    vkDestroyPipelineLayout(ctx.device, compDispPackLayout, nullptr);
+    vkDestroyPipelineLayout(ctx.device, compDispMipLayout, nullptr);
+    vkDestroyPipelineLayout(ctx.device, compValidateLayout, nullptr);
     if (compSprayUpdateLayout)
         vkDestroyPipelineLayout(ctx.device, compSprayUpdateLayout, nullptr);
     if (compSpraySpawnLayout)
         vkDestroyPipelineLayout(ctx.device, compSpraySpawnLayout, nullptr);
+    vkDestroyPipelineLayout(ctx.device, compWaterCullLayout, nullptr);
     if (sprayLayout)
         vkDestroyPipelineLayout(ctx.device, sprayLayout, nullptr);
     if (taaLayout)
@@ -3557,12 +5288,15 @@ int main(int argc, char **argv)
     vkDestroyDescriptorSetLayout(ctx.device, texSetLayout, nullptr);
     vkDestroyDescriptorSetLayout(ctx.device, compSpectrumSetLayout, nullptr);
     vkDestroyDescriptorSetLayout(ctx.device, comp2ImgSetLayout, nullptr);
-    vkDestroyDescriptorSetLayout(ctx.device, comp3ImgSetLayout, nullptr);
+    vkDestroyDescriptorSetLayout(ctx.device, compDispPackSetLayout, nullptr);
+    vkDestroyDescriptorSetLayout(ctx.device, twiddleSetLayout, nullptr);
     vkDestroyDescriptorSetLayout(ctx.device, compFoamSetLayout, nullptr);
+    vkDestroyDescriptorSetLayout(ctx.device, compValidateSetLayout, nullptr);
     if (compSpraySetLayout)
         vkDestroyDescriptorSetLayout(ctx.device, compSpraySetLayout, nullptr);
     if (spraySetLayout)
         vkDestroyDescriptorSetLayout(ctx.device, spraySetLayout, nullptr);
+    vkDestroyDescriptorSetLayout(ctx.device, compWaterCullSetLayout, nullptr);
     if (taaSetLayout)
         vkDestroyDescriptorSetLayout(ctx.device, taaSetLayout, nullptr);
     if (tonemapSetLayout)
@@ -3582,12 +5316,10 @@ int main(int argc, char **argv)
         destroyBuffer(ctx.device, taaUboBuf[i]);
     }
 
-    destroyBuffer(ctx.device, meshHi.vbo);
-    destroyBuffer(ctx.device, meshHi.ibo);
-    destroyBuffer(ctx.device, meshMid.vbo);
-    destroyBuffer(ctx.device, meshMid.ibo);
-    destroyBuffer(ctx.device, meshLo.vbo);
-    destroyBuffer(ctx.device, meshLo.ibo);
+    destroyBuffer(ctx.device, meshNode.vbo);
+    destroyBuffer(ctx.device, meshNode.ibo);
+    destroyBuffer(ctx.device, meshProjected.vbo);
+    destroyBuffer(ctx.device, meshProjected.ibo);
 
     if (fftSampler)
         vkDestroySampler(ctx.device, fftSampler, nullptr);
@@ -3624,22 +5356,40 @@ int main(int argc, char **argv)
     if (taaRenderPass)
         vkDestroyRenderPass(ctx.device, taaRenderPass, nullptr);
 
-    destroyImage(ctx.device, texH0);
-    destroyImage(ctx.device, texB0_0);
-    destroyImage(ctx.device, texB1_0);
-    destroyImage(ctx.device, texH1);
-    destroyImage(ctx.device, texB0_1);
-    destroyImage(ctx.device, texB1_1);
-    destroyImage(ctx.device, texBCombined);
+    destroyImage(ctx.device, texH0Cache);
+    destroyImage(ctx.device, texOmega);
+    destroyImage(ctx.device, texH);
+    destroyImage(ctx.device, texB0);
+    destroyImage(ctx.device, texB1);
+    for (VkImageView v : dispMipViews)
+        vkDestroyImageView(ctx.device, v, nullptr);
+    for (VkImageView v : derivMipViews)
+        vkDestroyImageView(ctx.device, v, nullptr);
+    destroyImage(ctx.device, texDisp);
+    destroyImage(ctx.device, texDeriv);
+    destroyImage(ctx.device, texDispRef);
+    if (validateMap)
+        vkUnmapMemory(ctx.device, validateBuf.memory);
+    destroyBuffer(ctx.device, validateBuf);
     destroyImage(ctx.device, foamImg[0]);
     destroyImage(ctx.device, foamImg[1]);
 
     destroyBuffer(ctx.device, sprayBuf);
     destroyBuffer(ctx.device, sprayCounter);
+    destroyBuffer(ctx.device, waterDrawBuf);
+    destroyBuffer(ctx.device, waterNodeBuf);
+    if (waterNodeRingMap)
+        vkUnmapMemory(ctx.device, waterNodeRing.memory);
+    destroyBuffer(ctx.device, waterNodeRing);
+    destroyBuffer(ctx.device, twiddleBuf);
+
+    profiler.cleanup(ctx.device);
+    computeProfiler.cleanup(ctx.device);
 
     ctx.cleanup();
 
-    glfwDestroyWindow(window);
+    if (window)
+        glfwDestroyWindow(window);
     glfwTerminate();
 
     return 0;
@@ -0,0 +1,125 @@
+#include "mesh_opt.h"
+
+VertexCacheStats measureVertexCache(const std::vector<uint32_t> &indices,
+                                    uint32_t vertexCount,
+                                    uint32_t cacheSize)
+{
+    VertexCacheStats stats{};
+    if (indices.empty() || vertexCount == 0)
+        return stats;
+
+    // FIFO: a vertex is cached while fewer than cacheSize misses came after its own
+    std::vector<uint64_t> missAt(vertexCount, 0);
+    std::vector<bool> used(vertexCount, false);
+    uint64_t misses = 0;
+    uint32_t unique = 0;
+    for (uint32_t v : indices)
+    {
+        if (!used[v])
+        {
+            used[v] = true;
+            unique++;
+        }
+        else if (misses - missAt[v] < cacheSize)
+            continue;
+        misses++;
+        missAt[v] = misses;
+    }
+
+    stats.acmr = float(misses) / float(indices.size() / 3);
+    stats.atvr = float(misses) / float(unique);
+    return stats;
+}
+
+void optimizeVertexCache(std::vector<uint32_t> &indices,
+                         uint32_t vertexCount,
+                         uint32_t cacheSize)
+{
+    const uint32_t triCount = uint32_t(indices.size() / 3);
+    if (triCount == 0 || vertexCount == 0)
+        return;
+
+    // triangles of every vertex, and how many of them are still to emit
+    std::vector<uint32_t> live(vertexCount, 0);
+    for (uint32_t v : indices)
+        live[v]++;
+    std::vector<uint32_t> first(vertexCount + 1, 0);
+    for (uint32_t v = 0; v < vertexCount; v++)
+        first[v + 1] = first[v] + live[v];
+    std::vector<uint32_t> adj(indices.size());
+    {
+        std::vector<uint32_t> fill(first.begin(), first.end() - 1);
+        for (uint32_t t = 0; t < triCount; t++)
+        {
+            for (uint32_t k = 0; k < 3; k++)
+                adj[fill[indices[t * 3 + k]]++] = t;
+        }
+    }
+
+    // cache time of every vertex: in cache while time - stamp <= cacheSize
+    std::vector<uint32_t> stamp(vertexCount, 0);
+    uint32_t time = cacheSize + 1;
+    std::vector<bool> emitted(triCount, false);
+    std::vector<uint32_t> deadEnd; // recently touched vertices, to restart from
+    std::vector<uint32_t> candidates;
+    uint32_t cursor = 0;
+
+    std::vector<uint32_t> out;
+    out.reserve(indices.size());
+
+    int64_t fan = 0;
+    while (fan >= 0)
+    {
+        // emit every remaining triangle around the fanning vertex
+        candidates.clear();
+        for (uint32_t a = first[fan]; a < first[fan + 1]; a++)
+        {
+            uint32_t t = adj[a];
+            if (emitted[t])
+                continue;
+            emitted[t] = true;
+            for (uint32_t k = 0; k < 3; k++)
+            {
+                uint32_t v = indices[t * 3 + k];
+                out.push_back(v);
+                deadEnd.push_back(v);
+                candidates.push_back(v);
+                live[v]--;
+                if (time - stamp[v] > cacheSize)
+                    stamp[v] = time++;
+            }
+        }
+
+        // next: the oldest candidate still in cache after its remaining triangles, else a dead end
+        fan = -1;
+        int64_t best = -1;
+        for (uint32_t v : candidates)
+        {
+            if (live[v] == 0)
+                continue;
+            int64_t priority = 0;
+            if (time - stamp[v] + 2 * live[v] <= cacheSize)
+                priority = time - stamp[v];
+            if (priority > best)
+            {
+                best = priority;
+                fan = v;
+            }
+        }
+        while (fan < 0 && !deadEnd.empty())
+        {
+            uint32_t v = deadEnd.back();
+            deadEnd.pop_back();
+            if (live[v] > 0)
+                fan = v;
+        }
+        while (fan < 0 && cursor < vertexCount)
+        {
+            if (live[cursor] > 0)
+                fan = cursor;
+            cursor++;
+        }
+    }
+
+    indices.swap(out);
+}
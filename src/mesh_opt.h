@@ -0,0 +1,25 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+
+// Post-transform vertex cache, simulated as a FIFO of cacheSize vertices.
+// ACMR: vertex shader runs per triangle (0.5 is ideal for a large grid, 3 the worst).
+// ATVR: vertex shader runs per referenced vertex (1 is ideal).
+struct VertexCacheStats
+{
+    float acmr = 0.0f;
+    float atvr = 0.0f;
+};
+
+static constexpr uint32_t kVertexCacheSize = 16;
+
+VertexCacheStats measureVertexCache(const std::vector<uint32_t> &indices,
+                                    uint32_t vertexCount,
+                                    uint32_t cacheSize = kVertexCacheSize);
+
+// Reorders the triangles of an indexed triangle list for the cache above (Tipsify, Sander,
+// Nehab and Barczak 2007): fans around the most recently used vertex whose remaining triangles
+// still fit in the cache, linear in the triangle count. Vertices keep their indices.
+void optimizeVertexCache(std::vector<uint32_t> &indices,
+                         uint32_t vertexCount,
+                         uint32_t cacheSize = kVertexCacheSize);
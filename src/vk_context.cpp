@@ -116,10 +116,17 @@ static bool checkDevice(VkPhysicalDevice dev, VkSurfaceKHR surface, uint32_t& ou
     vkGetPhysicalDeviceQueueFamilyProperties(dev, &qCount, qProps.data());
 
     // Require graphics + compute + present in one queue for simplicity
+    // (headless has no surface, so present is not required)
     for (uint32_t i = 0; i < qCount; ++i){
+        if (!(qProps[i].queueFlags & VK_QUEUE_GRAPHICS_BIT) || !(qProps[i].queueFlags & VK_QUEUE_COMPUTE_BIT))
+            continue;
+        if (surface == VK_NULL_HANDLE){
+            outQFamily = i;
+            return true;
+        }
         VkBool32 present = VK_FALSE;
         vkGetPhysicalDeviceSurfaceSupportKHR(dev, i, surface, &present);
-        if (present && (qProps[i].queueFlags & VK_QUEUE_GRAPHICS_BIT) && (qProps[i].queueFlags & VK_QUEUE_COMPUTE_BIT)){
+        if (present){
             outQFamily = i;
             // check swapchain
             auto sc = querySwapchainSupport(dev, surface);
@@ -129,6 +136,33 @@ static bool checkDevice(VkPhysicalDevice dev, VkSurfaceKHR surface, uint32_t& ou
     return false;
 }
 
+static void createDeviceImage(VkPhysicalDevice phys, VkDevice device, VkExtent2D extent, VkFormat format,
+                              VkImageUsageFlags usage, VkImage& outImage, VkDeviceMemory& outMem){
+    VkImageCreateInfo di{VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO};
+    di.imageType = VK_IMAGE_TYPE_2D;
+    di.extent = {extent.width, extent.height, 1};
+    di.mipLevels = 1;
+    di.arrayLayers = 1;
+    di.format = format;
+    di.tiling = VK_IMAGE_TILING_OPTIMAL;
+    di.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    di.usage = usage;
+    di.samples = VK_SAMPLE_COUNT_1_BIT;
+    di.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+    if (vkCreateImage(device, &di, nullptr, &outImage) != VK_SUCCESS)
+        throw std::runtime_error("vkCreateImage(render target) failed");
+
+    VkMemoryRequirements req{};
+    vkGetImageMemoryRequirements(device, outImage, &req);
+    VkMemoryAllocateInfo ai{VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO};
+    ai.allocationSize = req.size;
+    ai.memoryTypeIndex = findMemoryType(phys, req.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+    if (vkAllocateMemory(device, &ai, nullptr, &outMem) != VK_SUCCESS)
+        throw std::runtime_error("vkAllocateMemory(render target) failed");
+    vkBindImageMemory(device, outImage, outMem, 0);
+}
+
 void vkFramebufferResizeCallback(GLFWwindow* window, int, int){
     auto* ctx = reinterpret_cast<VkContext*>(glfwGetWindowUserPointer(window));
     if (ctx) ctx->framebufferResized = true;
@@ -136,7 +170,30 @@ void vkFramebufferResizeCallback(GLFWwindow* window, int, int){
 
 void VkContext::init(GLFWwindow* win, bool enableValidation){
     window = win;
+    headless = false;
+
+    createDevice(enableValidation);
+
+    // Swapchain + renderpass
+    recreateSwapchain();
 
+    // Hook resize callback
+    glfwSetWindowUserPointer(window, this);
+    glfwSetFramebufferSizeCallback(window, vkFramebufferResizeCallback);
+}
+
+void VkContext::initHeadless(uint32_t width, uint32_t height, bool enableValidation){
+    window = nullptr;
+    headless = true;
+    headlessExtent = {width, height};
+
+    createDevice(enableValidation);
+
+    // Offscreen targets + renderpass
+    recreateSwapchain();
+}
+
+void VkContext::createDevice(bool enableValidation){
     // Instance
     VkApplicationInfo app{VK_STRUCTURE_TYPE_APPLICATION_INFO};
     app.pApplicationName = "VulkanOcean";
@@ -145,9 +202,12 @@ void VkContext::init(GLFWwindow* win, bool enableValidation){
     app.engineVersion = VK_MAKE_VERSION(1,0,0);
     app.apiVersion = VK_API_VERSION_1_2;
 
-    uint32_t extCount = 0;
-    const char** exts = glfwGetRequiredInstanceExtensions(&extCount);
-    std::vector<const char*> extensions(exts, exts + extCount);
+    std::vector<const char*> extensions;
+    if (!headless){
+        uint32_t extCount = 0;
+        const char** exts = glfwGetRequiredInstanceExtensions(&extCount);
+        extensions.assign(exts, exts + extCount);
+    }
     if (enableValidation) extensions.push_back(VK_EXT_DEBUG_UTILS_EXTENSION_NAME);
 
     std::vector<const char*> layers;
@@ -177,8 +237,10 @@ void VkContext::init(GLFWwindow* win, bool enableValidation){
     }
 
     // Surface
-    if (glfwCreateWindowSurface(instance, window, nullptr, &surface) != VK_SUCCESS)
-        throw std::runtime_error("glfwCreateWindowSurface failed");
+    if (!headless){
+        if (glfwCreateWindowSurface(instance, window, nullptr, &surface) != VK_SUCCESS)
+            throw std::runtime_error("glfwCreateWindowSurface failed");
+    }
 
     // Pick physical device
     uint32_t devCount = 0;
@@ -199,27 +261,95 @@ void VkContext::init(GLFWwindow* win, bool enableValidation){
 
     VkPhysicalDeviceProperties props{};
     vkGetPhysicalDeviceProperties(phys, &props);
-    std::cout << "Using GPU: " << props.deviceName << "\n";
+    std::cout << "Using GPU: " << props.deviceName << (headless ? " (headless)" : "") << "\n";
+
+    // Async compute: a compute only family if there is one, else a second queue of the graphics
+    // family, and timeline semaphores for the handoff. Otherwise everything stays on graphicsQ
+    uint32_t computeQIndex = 0;
+    if (asyncCompute){
+        VkPhysicalDeviceVulkan12Features f12{VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES};
+        VkPhysicalDeviceFeatures2 f2{VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2};
+        f2.pNext = &f12;
+        if (props.apiVersion >= VK_API_VERSION_1_2) vkGetPhysicalDeviceFeatures2(phys, &f2);
+
+        uint32_t qCount = 0;
+        vkGetPhysicalDeviceQueueFamilyProperties(phys, &qCount, nullptr);
+        std::vector<VkQueueFamilyProperties> qProps(qCount);
+        vkGetPhysicalDeviceQueueFamilyProperties(phys, &qCount, qProps.data());
+
+        for (uint32_t i = 0; i < qCount; ++i){
+            if ((qProps[i].queueFlags & VK_QUEUE_COMPUTE_BIT) && !(qProps[i].queueFlags & VK_QUEUE_GRAPHICS_BIT)){
+                computeQFamily = i;
+                break;
+            }
+        }
+        if (computeQFamily == UINT32_MAX && qProps[graphicsQFamily].queueCount > 1){
+            computeQFamily = graphicsQFamily;
+            computeQIndex = 1;
+        }
+
+        if (!f12.timelineSemaphore || computeQFamily == UINT32_MAX){
+            std::cout << "Async compute: " << (f12.timelineSemaphore ? "no second compute queue" : "no timeline semaphores")
+                      << ", simulating on the graphics queue\n";
+            asyncCompute = false;
+            computeQFamily = UINT32_MAX;
+            computeQIndex = 0;
+        } else {
+            std::cout << "Async compute: queue family " << computeQFamily
+                      << (computeQFamily == graphicsQFamily ? " (second graphics queue)" : "") << "\n";
+        }
+    }
+
+    if (tessellation){
+        VkPhysicalDeviceFeatures pf{};
+        vkGetPhysicalDeviceFeatures(phys, &pf);
+        if (!pf.tessellationShader){
+            std::cout << "Tessellation: not supported, water drawn without it\n";
+            tessellation = false;
+        }
+    }
+
+    if (pipelineStatistics){
+        VkPhysicalDeviceFeatures pf{};
+        vkGetPhysicalDeviceFeatures(phys, &pf);
+        if (!pf.pipelineStatisticsQuery){
+            std::cout << "Pipeline statistics: not supported, no fragment invocation counts\n";
+            pipelineStatistics = false;
+        }
+    }
 
     // Device
-    float qPri = 1.0f;
+    float qPri[2] = {1.0f, 1.0f};
+    std::vector<VkDeviceQueueCreateInfo> qcis;
     VkDeviceQueueCreateInfo qci{VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO};
     qci.queueFamilyIndex = graphicsQFamily;
-    qci.queueCount = 1;
-    qci.pQueuePriorities = &qPri;
+    qci.queueCount = computeQIndex + 1;
+    qci.pQueuePriorities = qPri;
+    qcis.push_back(qci);
+    if (asyncCompute && computeQFamily != graphicsQFamily){
+        qci.queueFamilyIndex = computeQFamily;
+        qci.queueCount = 1;
+        qcis.push_back(qci);
+    }
+
+    VkPhysicalDeviceVulkan12Features enable12{VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES};
+    enable12.timelineSemaphore = VK_TRUE;
 
     VkPhysicalDeviceFeatures feats{};
     feats.samplerAnisotropy = VK_TRUE;
     feats.fillModeNonSolid = VK_TRUE;
+    feats.tessellationShader = tessellation ? VK_TRUE : VK_FALSE;
+    feats.pipelineStatisticsQuery = pipelineStatistics ? VK_TRUE : VK_FALSE;
 
     const char* devExts[] = { VK_KHR_SWAPCHAIN_EXTENSION_NAME };
 
     VkDeviceCreateInfo dci{VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO};
-    dci.queueCreateInfoCount = 1;
-    dci.pQueueCreateInfos = &qci;
+    dci.pNext = asyncCompute ? &enable12 : nullptr;
+    dci.queueCreateInfoCount = (uint32_t)qcis.size();
+    dci.pQueueCreateInfos = qcis.data();
     dci.pEnabledFeatures = &feats;
-    dci.enabledExtensionCount = 1;
-    dci.ppEnabledExtensionNames = devExts;
+    dci.enabledExtensionCount = headless ? 0 : 1;
+    dci.ppEnabledExtensionNames = headless ? nullptr : devExts;
     if (enableValidation){
         dci.enabledLayerCount = (uint32_t)layers.size();
         dci.ppEnabledLayerNames = layers.data();
@@ -259,14 +389,30 @@ void VkContext::init(GLFWwindow* win, bool enableValidation){
         vkCreateFence(device, &fci, nullptr, &frames[i].inFlight);
     }
 
-    depthFormat = findDepthFormat(phys);
+    if (asyncCompute){
+        vkGetDeviceQueue(device, computeQFamily, computeQIndex, &computeQ);
 
-    // Swapchain + renderpass
-    recreateSwapchain();
+        VkCommandPoolCreateInfo cpci{VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO};
+        cpci.queueFamilyIndex = computeQFamily;
+        cpci.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+        if (vkCreateCommandPool(device, &cpci, nullptr, &computeCmdPool) != VK_SUCCESS)
+            throw std::runtime_error("vkCreateCommandPool(compute) failed");
 
-    // Hook resize callback
-    glfwSetWindowUserPointer(window, this);
-    glfwSetFramebufferSizeCallback(window, vkFramebufferResizeCallback);
+        cai.commandPool = computeCmdPool;
+        if (vkAllocateCommandBuffers(device, &cai, cbufs) != VK_SUCCESS)
+            throw std::runtime_error("vkAllocateCommandBuffers(compute) failed");
+        for (uint32_t i=0;i<kMaxFrames;i++) frames[i].computeCmd = cbufs[i];
+
+        VkSemaphoreTypeCreateInfo tci{VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO};
+        tci.semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE;
+        tci.initialValue = 0;
+        VkSemaphoreCreateInfo sci{VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO};
+        sci.pNext = &tci;
+        if (vkCreateSemaphore(device, &sci, nullptr, &simTimeline) != VK_SUCCESS)
+            throw std::runtime_error("vkCreateSemaphore(timeline) failed");
+    }
+
+    depthFormat = findDepthFormat(phys);
 }
 
 void VkContext::waitIdle(){
@@ -276,19 +422,7 @@ void VkContext::waitIdle(){
 void VkContext::cleanup(){
     waitIdle();
 
-    for (auto fb : framebuffers) vkDestroyFramebuffer(device, fb, nullptr);
-    framebuffers.clear();
-
-    if (depthView) vkDestroyImageView(device, depthView, nullptr);
-    if (depthImage) vkDestroyImage(device, depthImage, nullptr);
-    if (depthMem) vkFreeMemory(device, depthMem, nullptr);
-
-    if (renderPass) vkDestroyRenderPass(device, renderPass, nullptr);
-
-    for (auto v : swapViews) vkDestroyImageView(device, v, nullptr);
-    swapViews.clear();
-
-    if (swapchain) vkDestroySwapchainKHR(device, swapchain, nullptr);
+    destroySwapchain();
 
     for (uint32_t i=0;i<kMaxFrames;i++){
         if (frames[i].imageAvailable) vkDestroySemaphore(device, frames[i].imageAvailable, nullptr);
@@ -297,6 +431,8 @@ void VkContext::cleanup(){
     }
 
     if (cmdPool) vkDestroyCommandPool(device, cmdPool, nullptr);
+    if (computeCmdPool) vkDestroyCommandPool(device, computeCmdPool, nullptr);
+    if (simTimeline) vkDestroySemaphore(device, simTimeline, nullptr);
 
     if (device) vkDestroyDevice(device, nullptr);
 
@@ -309,17 +445,7 @@ void VkContext::cleanup(){
     *this = {};
 }
 
-void VkContext::recreateSwapchain(){
-    int w=0, h=0;
-    glfwGetFramebufferSize(window, &w, &h);
-    while (w == 0 || h == 0){
-        glfwWaitEvents();
-        glfwGetFramebufferSize(window, &w, &h);
-    }
-
-    waitIdle();
-
-    // Cleanup old
+void VkContext::destroySwapchain(){
     for (auto fb : framebuffers) vkDestroyFramebuffer(device, fb, nullptr);
     framebuffers.clear();
 
@@ -331,77 +457,92 @@ void VkContext::recreateSwapchain(){
     for (auto v : swapViews) vkDestroyImageView(device, v, nullptr);
     swapViews.clear();
 
+    // offscreen images are ours, swapchain images belong to the swapchain
+    if (headless){
+        for (auto img : swapImages) vkDestroyImage(device, img, nullptr);
+        for (auto mem : offscreenMem) vkFreeMemory(device, mem, nullptr);
+        offscreenMem.clear();
+    }
+    swapImages.clear();
+
     if (swapchain) vkDestroySwapchainKHR(device, swapchain, nullptr);
     swapchain = {};
 
     if (renderPass) { vkDestroyRenderPass(device, renderPass, nullptr); renderPass = {}; }
+}
+
+void VkContext::recreateSwapchain(){
+    if (!headless){
+        int w=0, h=0;
+        glfwGetFramebufferSize(window, &w, &h);
+        while (w == 0 || h == 0){
+            glfwWaitEvents();
+            glfwGetFramebufferSize(window, &w, &h);
+        }
+    }
 
-    // Create swapchain
-    auto sc = querySwapchainSupport(phys, surface);
-    VkSurfaceFormatKHR surfFmt = chooseSurfaceFormat(sc.formats);
-    VkPresentModeKHR present = choosePresentMode(sc.modes);
-    VkExtent2D extent = chooseExtent(sc.caps, window);
-
-    uint32_t imageCount = sc.caps.minImageCount + 1;
-    if (sc.caps.maxImageCount > 0 && imageCount > sc.caps.maxImageCount)
-        imageCount = sc.caps.maxImageCount;
-
-    VkSwapchainCreateInfoKHR sci{VK_STRUCTURE_TYPE_SWAPCHAIN_CREATE_INFO_KHR};
-    sci.surface = surface;
-    sci.minImageCount = imageCount;
-    sci.imageFormat = surfFmt.format;
-    sci.imageColorSpace = surfFmt.colorSpace;
-    sci.imageExtent = extent;
-    sci.imageArrayLayers = 1;
-    sci.imageUsage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
-    sci.imageSharingMode = VK_SHARING_MODE_EXCLUSIVE;
-    sci.preTransform = sc.caps.currentTransform;
-    sci.compositeAlpha = VK_COMPOSITE_ALPHA_OPAQUE_BIT_KHR;
-    sci.presentMode = present;
-    sci.clipped = VK_TRUE;
-    sci.oldSwapchain = VK_NULL_HANDLE;
-
-    if (vkCreateSwapchainKHR(device, &sci, nullptr, &swapchain) != VK_SUCCESS)
-        throw std::runtime_error("vkCreateSwapchainKHR failed");
-
-    swapFormat = surfFmt.format;
-    swapExtent = extent;
-
-    uint32_t scCount = 0;
-    vkGetSwapchainImagesKHR(device, swapchain, &scCount, nullptr);
-    swapImages.resize(scCount);
-    vkGetSwapchainImagesKHR(device, swapchain, &scCount, swapImages.data());
+    waitIdle();
 
+    // Cleanup old
+    destroySwapchain();
+
+    if (headless){
+        // one color target per frame in flight, same format the swapchain would prefer
+        swapFormat = VK_FORMAT_B8G8R8A8_UNORM;
+        swapExtent = headlessExtent;
+        swapImages.resize(kMaxFrames);
+        offscreenMem.resize(kMaxFrames);
+        for (uint32_t i=0;i<kMaxFrames;i++){
+            createDeviceImage(phys, device, swapExtent, swapFormat,
+                              VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT,
+                              swapImages[i], offscreenMem[i]);
+        }
+    } else {
+        // Create swapchain
+        auto sc = querySwapchainSupport(phys, surface);
+        VkSurfaceFormatKHR surfFmt = chooseSurfaceFormat(sc.formats);
+        VkPresentModeKHR present = choosePresentMode(sc.modes);
+        VkExtent2D extent = chooseExtent(sc.caps, window);
+
+        uint32_t imageCount = sc.caps.minImageCount + 1;
+        if (sc.caps.maxImageCount > 0 && imageCount > sc.caps.maxImageCount)
+            imageCount = sc.caps.maxImageCount;
+
+        VkSwapchainCreateInfoKHR sci{VK_STRUCTURE_TYPE_SWAPCHAIN_CREATE_INFO_KHR};
+        sci.surface = surface;
+        sci.minImageCount = imageCount;
+        sci.imageFormat = surfFmt.format;
+        sci.imageColorSpace = surfFmt.colorSpace;
+        sci.imageExtent = extent;
+        sci.imageArrayLayers = 1;
+        sci.imageUsage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
+        sci.imageSharingMode = VK_SHARING_MODE_EXCLUSIVE;
+        sci.preTransform = sc.caps.currentTransform;
+        sci.compositeAlpha = VK_COMPOSITE_ALPHA_OPAQUE_BIT_KHR;
+        sci.presentMode = present;
+        sci.clipped = VK_TRUE;
+        sci.oldSwapchain = VK_NULL_HANDLE;
+
+        if (vkCreateSwapchainKHR(device, &sci, nullptr, &swapchain) != VK_SUCCESS)
+            throw std::runtime_error("vkCreateSwapchainKHR failed");
+
+        swapFormat = surfFmt.format;
+        swapExtent = extent;
+
+        uint32_t scCount = 0;
+        vkGetSwapchainImagesKHR(device, swapchain, &scCount, nullptr);
+        swapImages.resize(scCount);
+        vkGetSwapchainImagesKHR(device, swapchain, &scCount, swapImages.data());
+    }
+
+    const uint32_t scCount = (uint32_t)swapImages.size();
     swapViews.resize(scCount);
     for (uint32_t i=0;i<scCount;i++){
         swapViews[i] = createImageView(device, swapImages[i], swapFormat, VK_IMAGE_ASPECT_COLOR_BIT, 1);
     }
 
     // depth
-    VkImageCreateInfo di{VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO};
-    di.imageType = VK_IMAGE_TYPE_2D;
-    di.extent = {swapExtent.width, swapExtent.height, 1};
-    di.mipLevels = 1;
-    di.arrayLayers = 1;
-    di.format = depthFormat;
-    di.tiling = VK_IMAGE_TILING_OPTIMAL;
-    di.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-    di.usage = VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT;
-    di.samples = VK_SAMPLE_COUNT_1_BIT;
-    di.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
-
-    if (vkCreateImage(device, &di, nullptr, &depthImage) != VK_SUCCESS)
-        throw std::runtime_error("vkCreateImage(depth) failed");
-
-    VkMemoryRequirements req{};
-    vkGetImageMemoryRequirements(device, depthImage, &req);
-    VkMemoryAllocateInfo ai{VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO};
-    ai.allocationSize = req.size;
-    ai.memoryTypeIndex = findMemoryType(phys, req.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
-    if (vkAllocateMemory(device, &ai, nullptr, &depthMem) != VK_SUCCESS)
-        throw std::runtime_error("vkAllocateMemory(depth) failed");
-    vkBindImageMemory(device, depthImage, depthMem, 0);
-
+    createDeviceImage(phys, device, swapExtent, depthFormat, VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT, depthImage, depthMem);
     depthView = createImageView(device, depthImage, depthFormat, VK_IMAGE_ASPECT_DEPTH_BIT, 1);
 
     // render pass
@@ -413,7 +554,7 @@ void VkContext::recreateSwapchain(){
     color.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
     color.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
     color.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-    color.finalLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+    color.finalLayout = headless ? VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL : VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
 
     VkAttachmentDescription depth{};
     depth.format = depthFormat;
@@ -477,13 +618,18 @@ VkCommandBuffer VkContext::beginFrame(uint32_t& outImageIndex){
     VkFrame& fr = frames[frameIndex];
     vkWaitForFences(device, 1, &fr.inFlight, VK_TRUE, UINT64_MAX);
 
-    VkResult acq = vkAcquireNextImageKHR(device, swapchain, UINT64_MAX, fr.imageAvailable, VK_NULL_HANDLE, &outImageIndex);
-    if (acq == VK_ERROR_OUT_OF_DATE_KHR) {
-        recreateSwapchain();
-        return VK_NULL_HANDLE;
+    if (headless){
+        // offscreen image i is only ever used by frame slot i, so the fence above covers it
+        outImageIndex = frameIndex;
+    } else {
+        VkResult acq = vkAcquireNextImageKHR(device, swapchain, UINT64_MAX, fr.imageAvailable, VK_NULL_HANDLE, &outImageIndex);
+        if (acq == VK_ERROR_OUT_OF_DATE_KHR) {
+            recreateSwapchain();
+            return VK_NULL_HANDLE;
+        }
+        if (acq != VK_SUCCESS && acq != VK_SUBOPTIMAL_KHR)
+            throw std::runtime_error("vkAcquireNextImageKHR failed");
     }
-    if (acq != VK_SUCCESS && acq != VK_SUBOPTIMAL_KHR)
-        throw std::runtime_error("vkAcquireNextImageKHR failed");
 
     vkResetFences(device, 1, &fr.inFlight);
     vkResetCommandBuffer(fr.cmd, 0);
@@ -501,32 +647,144 @@ void VkContext::endFrame(uint32_t imageIndex){
     if (vkEndCommandBuffer(fr.cmd) != VK_SUCCESS)
         throw std::runtime_error("vkEndCommandBuffer failed");
 
-    VkPipelineStageFlags waitStage = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+    // swapchain image, and with async compute this frame's simulation before anything reads it
+    VkSemaphore waitSems[2]{};
+    VkPipelineStageFlags waitStages[2]{};
+    uint64_t waitValues[2]{};
+    uint32_t waitCount = 0;
+    if (!headless){
+        waitSems[waitCount] = fr.imageAvailable;
+        waitStages[waitCount] = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+        waitCount++;
+    }
+    if (simPending){
+        waitSems[waitCount] = simTimeline;
+        waitStages[waitCount] = VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_VERTEX_SHADER_BIT |
+                                VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+        waitValues[waitCount] = simValue;
+        waitCount++;
+        simPending = false;
+    }
+
+    VkTimelineSemaphoreSubmitInfo tsi{VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO};
+    tsi.waitSemaphoreValueCount = waitCount;
+    tsi.pWaitSemaphoreValues = waitValues;
+
     VkSubmitInfo si{VK_STRUCTURE_TYPE_SUBMIT_INFO};
-    si.waitSemaphoreCount = 1;
-    si.pWaitSemaphores = &fr.imageAvailable;
-    si.pWaitDstStageMask = &waitStage;
+    si.pNext = asyncCompute ? &tsi : nullptr;
     si.commandBufferCount = 1;
     si.pCommandBuffers = &fr.cmd;
-    si.signalSemaphoreCount = 1;
-    si.pSignalSemaphores = &fr.renderFinished;
+    si.waitSemaphoreCount = waitCount;
+    si.pWaitSemaphores = waitSems;
+    si.pWaitDstStageMask = waitStages;
+    if (!headless){
+        si.signalSemaphoreCount = 1;
+        si.pSignalSemaphores = &fr.renderFinished;
+    }
 
     if (vkQueueSubmit(graphicsQ, 1, &si, fr.inFlight) != VK_SUCCESS)
         throw std::runtime_error("vkQueueSubmit failed");
 
-    VkPresentInfoKHR pi{VK_STRUCTURE_TYPE_PRESENT_INFO_KHR};
-    pi.waitSemaphoreCount = 1;
-    pi.pWaitSemaphores = &fr.renderFinished;
-    pi.swapchainCount = 1;
-    pi.pSwapchains = &swapchain;
-    pi.pImageIndices = &imageIndex;
-
-    VkResult pres = vkQueuePresentKHR(presentQ, &pi);
-    if (pres == VK_ERROR_OUT_OF_DATE_KHR || pres == VK_SUBOPTIMAL_KHR || framebufferResized){
-        recreateSwapchain();
-    } else if (pres != VK_SUCCESS){
-        throw std::runtime_error("vkQueuePresentKHR failed");
+    if (!headless){
+        VkPresentInfoKHR pi{VK_STRUCTURE_TYPE_PRESENT_INFO_KHR};
+        pi.waitSemaphoreCount = 1;
+        pi.pWaitSemaphores = &fr.renderFinished;
+        pi.swapchainCount = 1;
+        pi.pSwapchains = &swapchain;
+        pi.pImageIndices = &imageIndex;
+
+        VkResult pres = vkQueuePresentKHR(presentQ, &pi);
+        if (pres == VK_ERROR_OUT_OF_DATE_KHR || pres == VK_SUBOPTIMAL_KHR || framebufferResized){
+            recreateSwapchain();
+        } else if (pres != VK_SUCCESS){
+            throw std::runtime_error("vkQueuePresentKHR failed");
+        }
     }
 
     frameIndex = (frameIndex + 1) % kMaxFrames;
 }
+
+VkCommandBuffer VkContext::beginCompute(){
+    // the graphics fence waited on in beginFrame covers this slot's last simulation too,
+    // its submit waited on it
+    VkCommandBuffer cmd = frames[frameIndex].computeCmd;
+    vkResetCommandBuffer(cmd, 0);
+
+    VkCommandBufferBeginInfo bi{VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO};
+    if (vkBeginCommandBuffer(cmd, &bi) != VK_SUCCESS)
+        throw std::runtime_error("vkBeginCommandBuffer(compute) failed");
+    return cmd;
+}
+
+void VkContext::submitCompute(){
+    VkCommandBuffer cmd = frames[frameIndex].computeCmd;
+    if (vkEndCommandBuffer(cmd) != VK_SUCCESS)
+        throw std::runtime_error("vkEndCommandBuffer(compute) failed");
+
+    simValue++;
+    VkTimelineSemaphoreSubmitInfo tsi{VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO};
+    tsi.signalSemaphoreValueCount = 1;
+    tsi.pSignalSemaphoreValues = &simValue;
+
+    VkSubmitInfo si{VK_STRUCTURE_TYPE_SUBMIT_INFO};
+    si.pNext = &tsi;
+    si.commandBufferCount = 1;
+    si.pCommandBuffers = &cmd;
+    si.signalSemaphoreCount = 1;
+    si.pSignalSemaphores = &simTimeline;
+
+    if (vkQueueSubmit(computeQ, 1, &si, VK_NULL_HANDLE) != VK_SUCCESS)
+        throw std::runtime_error("vkQueueSubmit(compute) failed");
+    simPending = true;
+}
+
+std::vector<uint32_t> VkContext::simQueueFamilies() const{
+    if (asyncCompute && computeQFamily != graphicsQFamily) return {graphicsQFamily, computeQFamily};
+    return {graphicsQFamily};
+}
+
+std::vector<uint8_t> VkContext::readbackImage(uint32_t imageIndex){
+    if (!headless || imageIndex >= swapImages.size())
+        throw std::runtime_error("readbackImage: no offscreen image to read");
+
+    waitIdle();
+
+    const uint32_t w = swapExtent.width, h = swapExtent.height;
+    const VkDeviceSize size = VkDeviceSize(w) * h * 4;
+    AllocatedBuffer staging = createBuffer(phys, device, size, VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+                                           VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+
+    VkCommandBuffer cmd = beginSingleTimeCommands(device, cmdPool);
+
+    // the render pass already left it in TRANSFER_SRC, only the memory dependency is missing
+    VkImageMemoryBarrier b{VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER};
+    b.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+    b.newLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+    b.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    b.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    b.image = swapImages[imageIndex];
+    b.subresourceRange = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1};
+    b.srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+    b.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+    vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT,
+                         0, 0, nullptr, 0, nullptr, 1, &b);
+
+    VkBufferImageCopy region{};
+    region.imageSubresource = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1};
+    region.imageExtent = {w, h, 1};
+    vkCmdCopyImageToBuffer(cmd, swapImages[imageIndex], VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, staging.buffer, 1, &region);
+
+    endSingleTimeCommands(device, graphicsQ, cmdPool, cmd);
+
+    std::vector<uint8_t> rgba((size_t)size);
+    void* map = nullptr;
+    vkMapMemory(device, staging.memory, 0, size, 0, &map);
+    std::memcpy(rgba.data(), map, (size_t)size);
+    vkUnmapMemory(device, staging.memory);
+    destroyBuffer(device, staging);
+
+    if (swapFormat == VK_FORMAT_B8G8R8A8_UNORM || swapFormat == VK_FORMAT_B8G8R8A8_SRGB){
+        for (size_t i = 0; i < rgba.size(); i += 4) std::swap(rgba[i + 0], rgba[i + 2]);
+    }
+    return rgba;
+}
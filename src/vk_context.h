@@ -12,12 +12,18 @@ struct VkFrame
     VkSemaphore renderFinished{};
     VkFence inFlight{};
     VkCommandBuffer cmd{};
+    VkCommandBuffer computeCmd{}; // async compute only
 };
 
 struct VkContext
 {
     GLFWwindow *window{};
 
+    // headless: no surface/swapchain, swapImages are offscreen images we own
+    bool headless = false;
+    VkExtent2D headlessExtent{};
+    std::vector<VkDeviceMemory> offscreenMem;
+
     VkInstance instance{};
     VkDebugUtilsMessengerEXT debugMessenger{};
     VkSurfaceKHR surface{};
@@ -29,6 +35,25 @@ struct VkContext
     VkQueue graphicsQ{};
     VkQueue presentQ{};
 
+    // async compute: request before init; cleared again when the device has no second queue
+    // or no timeline semaphores. The simulation is submitted to computeQ first and signals
+    // simTimeline = simValue, the graphics submit of the same frame waits on that value
+    bool asyncCompute = false;
+    uint32_t computeQFamily = UINT32_MAX;
+    VkQueue computeQ{};
+    VkCommandPool computeCmdPool{};
+    VkSemaphore simTimeline{};
+    uint64_t simValue = 0;
+    bool simPending = false;
+
+    // tessellated water: request before init; cleared again when the device has no tessellation
+    // shaders, the water then keeps the plain vertex path
+    bool tessellation = false;
+
+    // fragment shader invocation queries for the profiler: request before init; cleared when the
+    // device has no pipeline statistics queries
+    bool pipelineStatistics = false;
+
     VkSwapchainKHR swapchain{};
     VkFormat swapFormat{};
     VkExtent2D swapExtent{};
@@ -51,17 +76,33 @@ struct VkContext
     bool framebufferResized = false;
 
     void init(GLFWwindow *win, bool enableValidation);
+    void initHeadless(uint32_t width, uint32_t height, bool enableValidation);
     void cleanup();
 
+    // instance, device, queue, command pool and per-frame sync
+    void createDevice(bool enableValidation);
+
     // swapchain dependent
     void recreateSwapchain();
+    void destroySwapchain();
 
     // per-frame
     VkCommandBuffer beginFrame(uint32_t &outImageIndex);
     void endFrame(uint32_t imageIndex);
 
+    // async compute only: this slot's compute command buffer, call after beginFrame succeeded;
+    // submitCompute must come before endFrame
+    VkCommandBuffer beginCompute();
+    void submitCompute();
+
+    // families that share the simulation resources, one entry unless async compute is on
+    std::vector<uint32_t> simQueueFamilies() const;
+
     // util
     void waitIdle();
+
+    // headless only: copy a finished offscreen image back as tightly packed RGBA8
+    std::vector<uint8_t> readbackImage(uint32_t imageIndex);
 };
 
 void vkFramebufferResizeCallback(GLFWwindow *window, int width, int height);
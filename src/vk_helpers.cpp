@@ -41,7 +41,8 @@ uint32_t findMemoryType(VkPhysicalDevice phys, uint32_t typeFilter, VkMemoryProp
     throw std::runtime_error("Failed to find suitable memory type");
 }
 
-AllocatedBuffer createBuffer(VkPhysicalDevice phys, VkDevice device, VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags props)
+AllocatedBuffer createBuffer(VkPhysicalDevice phys, VkDevice device, VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags props,
+                             const std::vector<uint32_t> &queueFamilies)
 {
     AllocatedBuffer b{};
     b.size = size;
@@ -50,6 +51,12 @@ AllocatedBuffer createBuffer(VkPhysicalDevice phys, VkDevice device, VkDeviceSiz
     bi.size = size;
     bi.usage = usage;
     bi.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+    if (queueFamilies.size() > 1)
+    {
+        bi.sharingMode = VK_SHARING_MODE_CONCURRENT;
+        bi.queueFamilyIndexCount = (uint32_t)queueFamilies.size();
+        bi.pQueueFamilyIndices = queueFamilies.data();
+    }
 
     if (vkCreateBuffer(device, &bi, nullptr, &b.buffer) != VK_SUCCESS)
         throw std::runtime_error("vkCreateBuffer failed");
@@ -98,7 +105,7 @@ VkImageView createImageView(VkDevice device, VkImage image, VkFormat format, VkI
 
 AllocatedImage createImage2D(VkPhysicalDevice phys, VkDevice device, uint32_t w, uint32_t h, uint32_t mipLevels, VkFormat format,
                              VkImageUsageFlags usage, VkImageAspectFlags aspect, VkSampleCountFlagBits samples, VkImageTiling tiling,
-                             VkImageCreateFlags flags, uint32_t layers)
+                             VkImageCreateFlags flags, uint32_t layers, const std::vector<uint32_t> &queueFamilies)
 {
     AllocatedImage img{};
     img.width = w;
@@ -119,6 +126,12 @@ AllocatedImage createImage2D(VkPhysicalDevice phys, VkDevice device, uint32_t w,
     ii.usage = usage;
     ii.samples = samples;
     ii.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+    if (queueFamilies.size() > 1)
+    {
+        ii.sharingMode = VK_SHARING_MODE_CONCURRENT;
+        ii.queueFamilyIndexCount = (uint32_t)queueFamilies.size();
+        ii.pQueueFamilyIndices = queueFamilies.data();
+    }
 
     if (vkCreateImage(device, &ii, nullptr, &img.image) != VK_SUCCESS)
         throw std::runtime_error("vkCreateImage failed");
@@ -135,8 +148,12 @@ AllocatedImage createImage2D(VkPhysicalDevice phys, VkDevice device, uint32_t w,
 
     vkBindImageMemory(device, img.image, img.memory, 0);
 
-    // default view for 2D
-    VkImageViewType vt = (layers == 6 && (flags & VK_IMAGE_CREATE_CUBE_COMPATIBLE_BIT)) ? VK_IMAGE_VIEW_TYPE_CUBE : VK_IMAGE_VIEW_TYPE_2D;
+    // default view for 2D, cube or 2D array
+    VkImageViewType vt = VK_IMAGE_VIEW_TYPE_2D;
+    if (layers == 6 && (flags & VK_IMAGE_CREATE_CUBE_COMPATIBLE_BIT))
+        vt = VK_IMAGE_VIEW_TYPE_CUBE;
+    else if (layers > 1)
+        vt = VK_IMAGE_VIEW_TYPE_2D_ARRAY;
     img.view = createImageView(device, img.image, format, aspect, mipLevels, vt, 0, 0, layers);
 
     return img;
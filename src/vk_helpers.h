@@ -35,7 +35,8 @@ AllocatedBuffer createBuffer(
     VkDevice device,
     VkDeviceSize size,
     VkBufferUsageFlags usage,
-    VkMemoryPropertyFlags props);
+    VkMemoryPropertyFlags props,
+    const std::vector<uint32_t> &queueFamilies = {}); // more than one: concurrent sharing
 
 void destroyBuffer(VkDevice device, AllocatedBuffer &b);
 
@@ -50,7 +51,8 @@ AllocatedImage createImage2D(
     VkSampleCountFlagBits samples = VK_SAMPLE_COUNT_1_BIT,
     VkImageTiling tiling = VK_IMAGE_TILING_OPTIMAL,
     VkImageCreateFlags flags = 0,
-    uint32_t layers = 1);
+    uint32_t layers = 1,
+    const std::vector<uint32_t> &queueFamilies = {}); // more than one: concurrent sharing
 
 void destroyImage(VkDevice device, AllocatedImage &img);
 